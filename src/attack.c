@@ -16,116 +16,304 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
 #include <stdio.h>
 
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
 #include "attack.h"
-#include "defs.h"
+#include "bitboards.h"
 #include "board.h"
 #include "data.h"
+#include "defs.h"
+#include "init.h"
 #include "validate.h"
 
-int SqAttacked(const int sq, const int side, const Board *pos) {
+uint64_t KnightAttacks[SQUARE_NB];
+uint64_t KingAttacks[SQUARE_NB];
 
-	int pce, index, t_sq;
-	
-	ASSERT(SqOnBoard(sq));
-	ASSERT(SideValid(side));
-	ASSERT(CheckBoard(pos));
-	
-	// pawns
-	if (side == WHITE) {
-		if (   pos->pieces[sq-11] == wP
-			|| pos->pieces[sq-9] == wP) return 1;
-	}
-
-	else {
-		if (   pos->pieces[sq+11] == bP
-			|| pos->pieces[sq+9] == bP) return 1;
-	}
-	
-	// knights
-	for (index = 0; index < 8; ++index) {
-		pce = pos->pieces[sq + KnDir[index]];
-		ASSERT(PceValidEmptyOffbrd(pce));
-		if (pce != OFFBOARD && IsKn(pce) && PieceCol[pce] == side)
-			return 1;
-	}
-	
-	// rooks, queens
-	for (index = 0; index < 4; ++index) {
-		t_sq = sq + RkDir[index];
-		ASSERT(SqIs120(t_sq));
-		pce = pos->pieces[t_sq];
-		ASSERT(PceValidEmptyOffbrd(pce));
-		while (pce != OFFBOARD) {
-			if (pce != EMPTY) {
-				if (IsRQ(pce) && PieceCol[pce] == side)
-					return 1;
-
-				break;
-			}
-			t_sq += RkDir[index];
-			ASSERT(SqIs120(t_sq));
-			pce = pos->pieces[t_sq];
-		}
-	}
-	
-	// bishops, queens
-	for(index = 0; index < 4; ++index) {
-		t_sq = sq + BiDir[index];
-		ASSERT(SqIs120(t_sq));
-		pce = pos->pieces[t_sq];
-		ASSERT(PceValidEmptyOffbrd(pce));
-		while (pce != OFFBOARD) {
-			if (pce != EMPTY) {
-				if (IsBQ(pce) && PieceCol[pce] == side)
-					return 1;
-				
-				break;
-			}
-			t_sq += BiDir[index];
-			ASSERT(SqIs120(t_sq));
-			pce = pos->pieces[t_sq];
-		}
-	}
-	
-	// kings
-	for (index = 0; index < 8; ++index) {		
-		pce = pos->pieces[sq + KiDir[index]];
-		ASSERT(PceValidEmptyOffbrd(pce));
-		if (pce != OFFBOARD && IsKi(pce) && PieceCol[pce] == side)
-			return 1;
-	}
-	
-	return 0;
+uint64_t BetweenMasks[SQUARE_NB][SQUARE_NB];
+uint64_t LineMasks[SQUARE_NB][SQUARE_NB];
+
+Magic BishopTable[SQUARE_NB];
+Magic RookTable[SQUARE_NB];
+
+uint64_t BishopAttacksTable[0x1480];
+uint64_t RookAttacksTable[0x19000];
+
+static const int KnightSteps[8][2] = {{-2,-1}, {-2, 1}, {-1,-2}, {-1, 2}, { 1,-2}, { 1, 2}, { 2,-1}, { 2, 1}};
+static const int KingSteps[8][2]   = {{-1,-1}, {-1, 0}, {-1, 1}, { 0,-1}, { 0, 1}, { 1,-1}, { 1, 0}, { 1, 1}};
+static const int BishopSteps[4][2] = {{-1,-1}, {-1, 1}, { 1,-1}, { 1, 1}};
+static const int RookSteps[4][2]   = {{-1, 0}, { 0,-1}, { 0, 1}, { 1, 0}};
+
+#if !defined(USE_PEXT)
+
+static uint64_t magicRand(uint64_t *seed) {
+
+    // Private xorshift generator, so that searching for the magics
+    // does not disturb the sequence used for the Zobrist keys
+
+    *seed ^= *seed >> 12;
+    *seed ^= *seed << 25;
+    *seed ^= *seed >> 27;
+
+    return *seed * 2685821657736338717ull;
 }
 
-int KingSqAttacked(const Board *pos) {
-	return SqAttacked(pos->KingSq[pos->side], !pos->side, pos);
+#endif
+
+static int validCoordinate(int rank, int file) {
+    return 0 <= rank && rank < RANK_NB && 0 <= file && file < FILE_NB;
+}
+
+static uint64_t sliderAttacks(int sq, uint64_t occupied, const int steps[4][2]) {
+
+    uint64_t result = 0ull;
+
+    for (int i = 0; i < 4; i++) {
+
+        int rank = rank_of(sq) + steps[i][0];
+        int file = file_of(sq) + steps[i][1];
+
+        while (validCoordinate(rank, file)) {
+
+            result |= 1ull << makeSq(file, rank);
+
+            if (occupied & (1ull << makeSq(file, rank)))
+                break;
+
+            rank += steps[i][0], file += steps[i][1];
+        }
+    }
+
+    return result;
 }
 
-int KnightAttack(int side, int sq, const Board *pos) {
-    int Knight = side == WHITE ? wN : bN, t_sq;
+static uint64_t magicIndex(const Magic *table, uint64_t occupied) {
+
+#if defined(USE_PEXT)
+    return _pext_u64(occupied, table->mask);
+#else
+    return ((occupied & table->mask) * table->magic) >> table->shift;
+#endif
+}
+
+static void initSliderAttacks(Magic *table, uint64_t *attacks, const int steps[4][2]) {
+
+    static uint64_t occupancy[4096], reference[4096];
+
+#if !defined(USE_PEXT)
+
+    // Seeds for each rank known to find all the magics quickly
+    static const uint64_t Seeds[RANK_NB] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    static int epoch[4096], attempt = 0;
+
+    uint64_t seed;
+#endif
+
+    int size;
+    uint64_t edges, occupied;
+
+    table[0].offset = attacks;
+
+    for (int sq = 0; sq < SQUARE_NB; sq++) {
+
+        // The edges of the board never block a slider, unless the
+        // slider itself sits on that edge, so they can be ignored
+        edges = ((Rank1BB | Rank8BB) & ~RanksBB[rank_of(sq)])
+              | ((FileABB | FileHBB) & ~FilesBB[file_of(sq)]);
+
+        table[sq].mask  = sliderAttacks(sq, 0ull, steps) & ~edges;
+        table[sq].shift = 64 - popcount(table[sq].mask);
+
+        // Enumerate every subset of the mask with the Carry-Rippler
+        // trick, and store the reference attacks for each of them
+        size = 0, occupied = 0ull;
+        do {
+            occupancy[size] = occupied;
+            reference[size++] = sliderAttacks(sq, occupied, steps);
+            occupied = (occupied - table[sq].mask) & table[sq].mask;
+        } while (occupied);
+
+        if (sq < SQUARE_NB - 1)
+            table[sq+1].offset = table[sq].offset + size;
+
+#if defined(USE_PEXT)
+
+        for (int i = 0; i < size; i++)
+            table[sq].offset[magicIndex(&table[sq], occupancy[i])] = reference[i];
+
+#else
+
+        // Try sparse random numbers until one maps every subset
+        // without a destructive collision. The epoch avoids having
+        // to reset the attack table between the attempts
+        seed = Seeds[rank_of(sq)];
+
+        for (int i = 0; i < size; ) {
+
+            do table[sq].magic = magicRand(&seed) & magicRand(&seed) & magicRand(&seed);
+            while (popcount((table[sq].magic * table[sq].mask) >> 56) < 6);
+
+            for (++attempt, i = 0; i < size; i++) {
+
+                uint64_t index = magicIndex(&table[sq], occupancy[i]);
+
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    table[sq].offset[index] = reference[i];
+                }
+
+                else if (table[sq].offset[index] != reference[i])
+                    break;
+            }
+        }
 
-    for (int index = 0; index < 8; ++index) {
-        t_sq = sq + PceDir[wN][index];
-        if (!SQOFFBOARD(t_sq) && pos->pieces[t_sq] == Knight)
-            return 1;
+#endif
     }
-    return 0;
 }
 
-int BishopAttack(int side, int sq, int dir, const Board *pos) {
-    int Bishop = side == WHITE ? wB : bB;
-    int t_sq = sq + dir;
+void initAttacks() {
+
+    int rank, file;
+
+    for (int sq = 0; sq < SQUARE_NB; sq++) {
+
+        KnightAttacks[sq] = KingAttacks[sq] = 0ull;
 
-    while (!SQOFFBOARD(t_sq)) {
-        if (pos->pieces[t_sq] != EMPTY) {
-            if (pos->pieces[t_sq] == Bishop)
-                return 1;
-            return 0;
+        for (int i = 0; i < 8; i++) {
+
+            rank = rank_of(sq) + KnightSteps[i][0];
+            file = file_of(sq) + KnightSteps[i][1];
+            if (validCoordinate(rank, file))
+                KnightAttacks[sq] |= 1ull << makeSq(file, rank);
+
+            rank = rank_of(sq) + KingSteps[i][0];
+            file = file_of(sq) + KingSteps[i][1];
+            if (validCoordinate(rank, file))
+                KingAttacks[sq] |= 1ull << makeSq(file, rank);
         }
-        t_sq += dir;
     }
-    return 0;
-}
\ No newline at end of file
+
+    initSliderAttacks(BishopTable, BishopAttacksTable, BishopSteps);
+    initSliderAttacks(RookTable, RookAttacksTable, RookSteps);
+
+    // Squares strictly between two aligned squares, and the whole
+    // line through them, both empty when the squares don't align
+    for (int s1 = 0; s1 < SQUARE_NB; s1++) {
+        for (int s2 = 0; s2 < SQUARE_NB; s2++) {
+
+            uint64_t ends = (1ull << s1) | (1ull << s2);
+
+            BetweenMasks[s1][s2] = LineMasks[s1][s2] = 0ull;
+
+            if (s1 == s2) continue;
+
+            if (bishopAttacks(s1, 0ull) & (1ull << s2)) {
+                BetweenMasks[s1][s2] = bishopAttacks(s1, 1ull << s2) & bishopAttacks(s2, 1ull << s1);
+                LineMasks[s1][s2] = (bishopAttacks(s1, 0ull) & bishopAttacks(s2, 0ull)) | ends;
+            }
+
+            if (rookAttacks(s1, 0ull) & (1ull << s2)) {
+                BetweenMasks[s1][s2] = rookAttacks(s1, 1ull << s2) & rookAttacks(s2, 1ull << s1);
+                LineMasks[s1][s2] = (rookAttacks(s1, 0ull) & rookAttacks(s2, 0ull)) | ends;
+            }
+        }
+    }
+}
+
+uint64_t betweenSquares(int s1, int s2) {
+    ASSERT(0 <= s1 && s1 < SQUARE_NB);
+    ASSERT(0 <= s2 && s2 < SQUARE_NB);
+    return BetweenMasks[s1][s2];
+}
+
+uint64_t lineThrough(int s1, int s2) {
+    ASSERT(0 <= s1 && s1 < SQUARE_NB);
+    ASSERT(0 <= s2 && s2 < SQUARE_NB);
+    return LineMasks[s1][s2];
+}
+
+uint64_t knightAttacks(int sq) {
+    ASSERT(0 <= sq && sq < SQUARE_NB);
+    return KnightAttacks[sq];
+}
+
+uint64_t bishopAttacks(int sq, uint64_t occupied) {
+    ASSERT(0 <= sq && sq < SQUARE_NB);
+    return BishopTable[sq].offset[magicIndex(&BishopTable[sq], occupied)];
+}
+
+uint64_t rookAttacks(int sq, uint64_t occupied) {
+    ASSERT(0 <= sq && sq < SQUARE_NB);
+    return RookTable[sq].offset[magicIndex(&RookTable[sq], occupied)];
+}
+
+uint64_t queenAttacks(int sq, uint64_t occupied) {
+    ASSERT(0 <= sq && sq < SQUARE_NB);
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+uint64_t kingAttacks(int sq) {
+    ASSERT(0 <= sq && sq < SQUARE_NB);
+    return KingAttacks[sq];
+}
+
+uint64_t pieceAttacks(int piece, int sq, uint64_t occupied) {
+
+    ASSERT(PieceValid(piece) && !PiecePawn[piece]);
+
+    switch (pieceType(piece)) {
+        case KNIGHT: return knightAttacks(sq);
+        case BISHOP: return bishopAttacks(sq, occupied);
+        case ROOK  : return rookAttacks(sq, occupied);
+        case QUEEN : return queenAttacks(sq, occupied);
+        case KING  : return kingAttacks(sq);
+        default    : ASSERT(0); return 0ull;
+    }
+}
+
+uint64_t attackersToSquare(const Board *pos, int sq, uint64_t occupied) {
+
+    // Pieces of both colours attacking the 64 based square, given
+    // the occupancy, which lets SEE reveal x-rays as it goes
+
+    uint64_t bishops = pos->pieceBB[wB] | pos->pieceBB[bB] | pos->pieceBB[wQ] | pos->pieceBB[bQ];
+    uint64_t rooks   = pos->pieceBB[wR] | pos->pieceBB[bR] | pos->pieceBB[wQ] | pos->pieceBB[bQ];
+
+    return (pawnAttacks(BLACK, sq) & pos->pieceBB[wP])
+         | (pawnAttacks(WHITE, sq) & pos->pieceBB[bP])
+         | (knightAttacks(sq) & (pos->pieceBB[wN] | pos->pieceBB[bN]))
+         | (bishopAttacks(sq, occupied) & bishops)
+         | (rookAttacks(sq, occupied) & rooks)
+         | (kingAttacks(sq) & (pos->pieceBB[wK] | pos->pieceBB[bK]));
+}
+
+int SqAttacked(const int sq, const int side, const Board *pos) {
+
+	ASSERT(SqOnBoard(sq));
+	ASSERT(SideValid(side));
+	ASSERT(CheckBoard(pos));
+
+	const int s = SQ64(sq);
+	const uint64_t occupied = pos->colourBB[COLOUR_NB];
+
+	const int Pawn   = side == WHITE ? wP : bP;
+	const int Knight = side == WHITE ? wN : bN;
+	const int Bishop = side == WHITE ? wB : bB;
+	const int Rook   = side == WHITE ? wR : bR;
+	const int Queen  = side == WHITE ? wQ : bQ;
+	const int King   = side == WHITE ? wK : bK;
+
+	return (pawnAttacks(!side, s) & pos->pieceBB[Pawn])
+	    || (knightAttacks(s) & pos->pieceBB[Knight])
+	    || (bishopAttacks(s, occupied) & (pos->pieceBB[Bishop] | pos->pieceBB[Queen]))
+	    || (rookAttacks(s, occupied) & (pos->pieceBB[Rook] | pos->pieceBB[Queen]))
+	    || (kingAttacks(s) & pos->pieceBB[King]);
+}
+
+int KingSqAttacked(const Board *pos) {
+	return SqAttacked(pos->KingSq[pos->side], !pos->side, pos);
+}
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include "defs.h"
 #include "data.h"
 
@@ -26,12 +28,24 @@
 #define IsKn(p) (PieceKnight[(p)])
 #define IsKi(p) (PieceKing[(p)])
 
+struct Magic {
+    uint64_t magic;   // Multiplier, unused when indexing with PEXT
+    uint64_t mask;    // Relevant occupancy, excluding the board edges
+    uint64_t *offset; // Start of this square's slice of the attack table
+    int shift;
+};
+
+void initAttacks();
+
+uint64_t knightAttacks(int sq);
+uint64_t bishopAttacks(int sq, uint64_t occupied);
+uint64_t rookAttacks(int sq, uint64_t occupied);
+uint64_t queenAttacks(int sq, uint64_t occupied);
+uint64_t kingAttacks(int sq);
+uint64_t pieceAttacks(int piece, int sq, uint64_t occupied);
+uint64_t attackersToSquare(const Board *pos, int sq, uint64_t occupied);
+uint64_t betweenSquares(int s1, int s2);
+uint64_t lineThrough(int s1, int s2);
+
 int SqAttacked(const int sq, const int side, const Board *pos);
-int BishopAttack(int side, int sq, int dir, const Board *pos);
-int KnightAttack(int side, int sq, const Board *pos);
 int KingSqAttacked(const Board *pos);
-
-static const int KnDir[8] = { -8, -19,	-21, -12, 8, 19, 21, 12 };
-static const int RkDir[4] = { -1, -10,	1, 10 };
-static const int BiDir[4] = { -9, -11, 11, 9 };
-static const int KiDir[8] = { -1, -10,	1, 10, -9, -11, 11, 9 };
\ No newline at end of file
@@ -18,7 +18,9 @@
 
 // board.c
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "attack.h"
 #include "bitboards.h"
@@ -104,6 +106,16 @@ int CheckBoard(const Board *pos) {
 		ASSERT(t_pceNum[t_piece] == pos->pceNum[t_piece]);
 	}
 
+	// check the piece and colour bitboards against the mailbox
+	for (sq64 = 0; sq64 < 64; ++sq64) {
+		t_piece = pos->pieces[SQ120(sq64)];
+		for (int pce = wP; pce <= bK; ++pce)
+			ASSERT(testBit(pos->pieceBB[pce], sq64) == (t_piece == pce));
+		ASSERT(testBit(pos->colourBB[WHITE], sq64) == (t_piece != EMPTY && PieceCol[t_piece] == WHITE));
+		ASSERT(testBit(pos->colourBB[BLACK], sq64) == (t_piece != EMPTY && PieceCol[t_piece] == BLACK));
+		ASSERT(testBit(pos->colourBB[COLOUR_NB], sq64) == (t_piece != EMPTY));
+	}
+
 	// check bitboards count
 	pcount = popcount(t_pawns[WHITE]);
 	ASSERT(pcount == pos->pceNum[wP]);
@@ -133,6 +145,7 @@ int CheckBoard(const Board *pos) {
 
 	ASSERT(pos->side==WHITE || pos->side==BLACK);
 	ASSERT(GeneratePosKey(pos) == pos->posKey);
+	ASSERT(GeneratePawnKey(pos) == pos->pawnKey);
 
 	ASSERT(    pos->enPas == NO_SQ
 		   || (RanksBrd[pos->enPas] == RANK_6 && pos->side == WHITE)
@@ -150,48 +163,55 @@ int CheckBoard(const Board *pos) {
 
 #endif
 
+static void UpdateListsPiece(Board *pos, int piece, int sq) {
+
+	int colour = PieceCol[piece];
+	ASSERT(SideValid(colour));
+
+	if (PieceBig[piece]) pos->bigPce[colour]++;
+
+	pos->PSQT[colour] += e.PSQT[piece][sq];
+
+	pos->material[colour] += PieceValue[EG][piece];
+	pos->mPhases[colour] += PieceValPhases[piece];
+
+	ASSERT(pos->pceNum[piece] < 10 && pos->pceNum[piece] >= 0);
+
+	pos->pList[piece][pos->pceNum[piece]] = sq;
+	pos->pceNum[piece]++;
+
+	if (piece == wP || piece == bP) {
+		int ne = (colour == WHITE ?  9 :  -9);
+		int nw = (colour == WHITE ? 11 : -11);
+		pos->pawn_ctrl[colour][sq + ne]++;
+		pos->pawn_ctrl[colour][sq + nw]++;	
+	}
+	
+	if (piece == wK) pos->KingSq[WHITE] = sq;
+	if (piece == bK) pos->KingSq[BLACK] = sq;
+
+	setBit(&pos->pieceBB[piece], SQ64(sq));
+	setBit(&pos->colourBB[colour], SQ64(sq));
+	setBit(&pos->colourBB[COLOUR_NB], SQ64(sq));
+
+	if (piece == wP) {
+		setBit(&pos->pawns[WHITE], SQ64(sq));
+		setBit(&pos->pawns[COLOUR_NB], SQ64(sq));
+	} else if(piece == bP) {
+		setBit(&pos->pawns[BLACK], SQ64(sq));
+		setBit(&pos->pawns[COLOUR_NB], SQ64(sq));
+	}
+}
+
 void UpdateListsMaterial(Board *pos) {
 
-	int piece, sq, index, colour;
+	int piece, index;
 
 	for (index = 0; index < BRD_SQ_NUM; ++index) {
-		sq = index;
 		piece = pos->pieces[index];
 		ASSERT(PceValidEmptyOffbrd(piece));
-		if (piece != OFFBOARD && piece != EMPTY) {
-			colour = PieceCol[piece];
-			ASSERT(SideValid(colour));
-
-		    if (PieceBig[piece]) pos->bigPce[colour]++;
-
-		    pos->PSQT[colour] += e.PSQT[piece][sq];
-
-			pos->material[colour] += PieceValue[EG][piece];
-			pos->mPhases[colour] += PieceValPhases[piece];
-
-			ASSERT(pos->pceNum[piece] < 10 && pos->pceNum[piece] >= 0);
-
-			pos->pList[piece][pos->pceNum[piece]] = sq;
-			pos->pceNum[piece]++;
-
-			if (piece == wP || piece == bP) {
-				int ne = (colour == WHITE ?  9 :  -9);
-				int nw = (colour == WHITE ? 11 : -11);
-				pos->pawn_ctrl[colour][sq + ne]++;
-				pos->pawn_ctrl[colour][sq + nw]++;	
-			}
-			
-			if (piece == wK) pos->KingSq[WHITE] = sq;
-			if (piece == bK) pos->KingSq[BLACK] = sq;
-
-			if (piece == wP) {
-				setBit(&pos->pawns[WHITE], SQ64(sq));
-				setBit(&pos->pawns[COLOUR_NB], SQ64(sq));
-			} else if(piece == bP) {
-				setBit(&pos->pawns[BLACK], SQ64(sq));
-				setBit(&pos->pawns[COLOUR_NB], SQ64(sq));
-			}
-		}
+		if (piece != OFFBOARD && piece != EMPTY)
+			UpdateListsPiece(pos, piece, index);
 	}
 }
 
@@ -309,10 +329,74 @@ int ParseFen(char *fen, Board *pos) {
 
 	UpdateListsMaterial(pos);
 	pos->materialKey = GenerateMaterialKey(pos);
+	pos->pawnKey = GeneratePawnKey(pos);
 
 	return 0;
 }
 
+void packBoard(const Board *pos, PackedBoard *packed) {
+
+	int sq64, count = 0;
+
+	*packed = (PackedBoard) {0};
+	packed->occupied = pos->colourBB[COLOUR_NB];
+
+	// Two pieces per byte, in the order of the occupied squares
+	for (uint64_t occupied = packed->occupied; occupied; count++) {
+		sq64 = poplsb(&occupied);
+		packed->pieces[count / 2] |= pos->pieces[SQ120(sq64)] << (4 * (count % 2));
+	}
+
+	packed->flags     = pos->side | (pos->castlePerm << 1);
+	packed->enPas     = pos->enPas == NO_SQ ? 64 : SQ64(pos->enPas);
+	packed->fiftyMove = pos->fiftyMove;
+	packed->fullMove  = pos->gamePly / 2 + 1;
+	packed->result    = PACKED_NO_RESULT;
+}
+
+void unpackBoard(const PackedBoard *packed, Board *pos) {
+
+	int sq64, sq120, piece, count = 0;
+
+	ResetBoard(pos);
+
+	// Place the pieces and fill the lists and keys in a single pass,
+	// instead of going through every square of the board once for each
+	for (uint64_t occupied = packed->occupied; occupied; count++) {
+
+		sq64  = poplsb(&occupied);
+		sq120 = SQ120(sq64);
+		piece = (packed->pieces[count / 2] >> (4 * (count % 2))) & 0xF;
+
+		ASSERT(PieceValid(piece));
+
+		pos->pieces[sq120] = piece;
+		pos->posKey ^= PieceKeys[piece][sq120];
+		if (piece == wP || piece == bP)
+			pos->pawnKey ^= PieceKeys[piece][sq120];
+
+		UpdateListsPiece(pos, piece, sq120);
+	}
+
+	pos->side       = packed->flags & 1;
+	pos->castlePerm = packed->flags >> 1;
+	pos->enPas      = packed->enPas == 64 ? NO_SQ : SQ120(packed->enPas);
+	pos->fiftyMove  = packed->fiftyMove;
+	pos->hisPly     = packed->fullMove;
+	pos->gamePly    = MAX(2 * (packed->fullMove - 1), 0) + (pos->side == BLACK);
+
+	if (pos->enPas != NO_SQ)
+		pos->posKey ^= PieceKeys[EMPTY][pos->enPas];
+
+	if (pos->side == WHITE)
+		pos->posKey ^= SideKey;
+
+	pos->posKey ^= CastleKeys[pos->castlePerm];
+	pos->materialKey = GenerateMaterialKey(pos);
+
+	ASSERT(CheckBoard(pos));
+}
+
 void ResetBoard(Board *pos) {
 
 	int index = 0;
@@ -334,7 +418,10 @@ void ResetBoard(Board *pos) {
 		pos->pieces[SQ120(index)] = EMPTY;
 
 	for (index = 0; index < 3; ++index)
-		pos->pawns[index] = 0ull;
+		pos->pawns[index] = pos->colourBB[index] = 0ull;
+
+	for (index = 0; index < PIECE_NB; ++index)
+		pos->pieceBB[index] = 0ull;
 
 	for (index = 0; index < 13; ++index)
 		pos->pceNum[index] = 0;
@@ -350,7 +437,24 @@ void ResetBoard(Board *pos) {
 
 	pos->castlePerm = 0;
 
-	pos->posKey = pos->materialKey = 0ULL;
+	pos->posKey = pos->materialKey = pos->pawnKey = 0ULL;
+}
+
+void cloneBoard(Board *dst, Undo *history, const Board *src) {
+
+	// Copy a position onto a new game history stack, keeping the
+	// entries of the moves played so far for repetition detection.
+	// A position from a FEN alone has no moves to remember at all
+
+	int entries = MIN(src->hisPly, MAXGAMEMOVES);
+
+	*dst = *src;
+	dst->history = history;
+
+	if (src->history != NULL)
+		memcpy(history, src->history, sizeof(Undo) * entries);
+	else
+		memset(history, 0, sizeof(Undo) * entries);
 }
 
 void PrintBoard(const Board *pos) {
@@ -421,6 +525,7 @@ void MirrorBoard(Board *pos) {
 
 	UpdateListsMaterial(pos);
 	pos->materialKey = GenerateMaterialKey(pos);
+	pos->pawnKey = GeneratePawnKey(pos);
 
     ASSERT(CheckBoard(pos));
 }
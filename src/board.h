@@ -24,37 +24,68 @@
 #include "makemove.h"
 #include "search.h"
 
+// The position alone, about a kilobyte, so that it is cheap to copy.
+// The Undo stack of the game lives with the owner of the Board, a
+// Thread or a perft worker, and history only points to it. Squares,
+// pieces and pawn counts all fit in a byte
+
 struct Board {
 
-	uint64_t posKey, materialKey, pawns[3];
+	uint64_t posKey, materialKey, pawnKey, pawns[3];
+	uint64_t pieceBB[PIECE_NB], colourBB[3];
 
 	int side, enPas, castlePerm, fiftyMove;
 	int ply, hisPly, gamePly, plyFromNull;
 
 	int PSQT[COLOUR_NB];
 	int KingSq[COLOUR_NB];
-	int pieces[BRD_SQ_NUM];
-	int pawn_ctrl[COLOUR_NB][BRD_SQ_NUM];
+	uint8_t pieces[BRD_SQ_NUM];
+	uint8_t pawn_ctrl[COLOUR_NB][BRD_SQ_NUM];
 
 	// piece list
-	int pList[PIECE_NB][10];
+	uint8_t pList[PIECE_NB][10];
 	int pceNum[PIECE_NB];
 	int bigPce[COLOUR_NB];
 	int mPhases[COLOUR_NB];
 	int material[COLOUR_NB];
 
-	PVariation pv;
-	Undo history[MAXGAMEMOVES];
+	Undo *history;
+};
+
+// An entry of the game history stack, for every move played. Built with
+// COPYMAKE, it also keeps the whole position from before the move, so
+// that taking the move back is a single copy instead of a reversal of
+// every incremental update. That makes an entry 840 bytes instead of 40
+
+struct Undo {
+	uint64_t posKey, materialKey;
+	int move, enPas, castlePerm;
+	int fiftyMove, plyFromNull;
+#if defined(COPYMAKE)
+	Board board;
+#endif
+};
+
+// A position in 32 bytes, for the bulk workloads of evalbook and the
+// tuner. The 4-bit piece codes follow the order of the occupied squares,
+// eval is a side to move score and result is in half points for White
 
-	KillerTable killers;
-    CounterMoveTable cmtable;
-    HistoryTable mainHistory;
-    ContinuationTable continuation;
+struct PackedBoard {
+	uint64_t occupied;
+	uint8_t pieces[16];
+	uint8_t flags, enPas, fiftyMove, result;
+	uint16_t fullMove;
+	int16_t eval;
 };
 
+enum { PACKED_NO_RESULT = 3 };
+
 int ParseFen(char *fen, Board *pos);
+void packBoard(const Board *pos, PackedBoard *packed);
+void unpackBoard(const PackedBoard *packed, Board *pos);
 void UpdateListsMaterial(Board *pos);
 void ResetBoard(Board *pos);
+void cloneBoard(Board *dst, Undo *history, const Board *src);
 void MirrorBoard(Board *pos);
 void PrintBoard(const Board *pos);
 
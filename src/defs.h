@@ -74,7 +74,11 @@ enum {
     INFINITE   = 32000,
     VALUE_NONE = 32001,
     MATE_IN_MAX  = INFINITE - MAX_PLY,
-    MATED_IN_MAX = MAX_PLY - INFINITE
+    MATED_IN_MAX = MAX_PLY - INFINITE,
+
+    VALUE_TB_WIN         = MATE_IN_MAX - 1,
+    VALUE_TB_WIN_IN_MAX  = VALUE_TB_WIN - MAX_PLY,
+    VALUE_TB_LOSS_IN_MAX = -VALUE_TB_WIN_IN_MAX
 };
 
 enum {
@@ -89,8 +93,6 @@ enum {
 	NORTH_WEST = NORTH + WEST
 };
 
-#define PRIu64 "I64u"
-
 #define MIN(A,B) ((A) < (B) ? (A) : (B))
 #define MAX(A,B) ((A) > (B) ? (A) : (B))
 
@@ -102,17 +104,25 @@ typedef struct evalInfo evalInfo;
 typedef struct evalData evalData;
 typedef struct EvalTrace EvalTrace;
 typedef struct KPKPos KPKPos;
+typedef struct Magic Magic;
 typedef struct Material_Entry Material_Entry;
 typedef struct Material_Table Material_Table;
 typedef struct MovePicker MovePicker;
 typedef struct Move Move;
 typedef struct MoveList MoveList;
+typedef struct PackedBoard PackedBoard;
 typedef struct Limits Limits;
+typedef struct Pawn_Entry Pawn_Entry;
+typedef struct Pawn_Table Pawn_Table;
 typedef struct PVariation PVariation;
+typedef struct RootMove RootMove;
 typedef struct TTable TTable;
 typedef struct TT_Cluster TT_Cluster;
 typedef struct TT_Entry TT_Entry;
 typedef struct SearchInfo SearchInfo;
+typedef struct Thread Thread;
+typedef struct TimeManager TimeManager;
+typedef struct UCIGoStruct UCIGoStruct;
 typedef struct Undo Undo;
 
 typedef int KillerTable[MAX_PLY+1][2];
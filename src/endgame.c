@@ -11,8 +11,6 @@
 #include "evaluate.h"
 #include "init.h"
 
-Material_Table Table;
-
 uint64_t MaterialKeys[COLOUR_NB][ENDGAME_NB];
 
 void endgameInit(Board *pos) {
@@ -43,6 +41,12 @@ void endgameAdd(Board *pos, int eg, char *fen) {
 	MaterialKeys[BLACK][eg] = pos->materialKey;
 }
 
+void prefetchMaterialTable(Material_Table *materialTable, uint64_t key) {
+
+    Material_Entry *entry = &materialTable->entry[key >> MT_HASH_SHIFT];
+    __builtin_prefetch(entry);
+}
+
 Material_Entry* Material_probe(const Board *pos, Material_Table *materialTable) {
 
 	uint64_t key = pos->materialKey;
@@ -182,7 +186,8 @@ int EndgameKXK(const Board *pos, int strongSide) {
     if (   pos->pceNum[queen ]
     	|| pos->pceNum[rook  ]
     	||(pos->pceNum[bishop] && pos->pceNum[knight])
-    	|| (   opposite_colors(SQ64(pos->pList[bishop][0]), SQ64(A1))
+    	|| (   pos->pceNum[bishop] >= 2
+        	&& opposite_colors(SQ64(pos->pList[bishop][0]), SQ64(A1))
         	&& opposite_colors(SQ64(pos->pList[bishop][1]), SQ64(A8))) )
         result = MIN(result + KNOWN_WIN, MATE_IN_MAX - 1);
 
@@ -654,9 +659,9 @@ int EndgameKRPKB(const Board *pos, int strongSide) {
             		}
             		else
             			break;
-            	}
 
-            	t_sq += PceDir[bishop][index];
+            		t_sq += PceDir[bishop][index];
+            	}
         	}
     	}
 	}
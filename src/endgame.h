@@ -22,8 +22,6 @@
 
 #include "defs.h"
 
-extern Material_Table Table;
-
 enum {
     KPK,
     KBNK,
@@ -89,6 +87,7 @@ void endgameInit(Board *pos);
 void endgameAdd(Board *pos, int eg, char *fen);
 int fixSquare(const Board *pos, int strongSide, int sq);
 
+void prefetchMaterialTable(Material_Table *materialTable, uint64_t key);
 Material_Entry* Material_probe(const Board *pos, Material_Table *materialTable);
 int EndgameValue_probe(const Board *pos, uint64_t key);
 int EndgameFactor_probe(const Board *pos, uint64_t key);
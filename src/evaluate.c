@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "attack.h"
 #include "bitboards.h"
 #include "board.h"
 #include "data.h"
@@ -29,10 +30,11 @@
 #include "endgame.h"
 #include "evaluate.h"
 #include "init.h"
+#include "pawns.h"
+#include "thread.h"
 #include "validate.h"
 
 EvalTrace T, EmptyTrace;
-evalInfo ei;
 evalData e;
 
 int getTropism(const int s1, const int s2) {
@@ -58,79 +60,20 @@ int isPiece(const int piece, const int sq, const Board *pos) {
     return (pos->pieces[sq] == piece);
 }
 
-int NonSlideMob(const Board *pos, int side, int pce, int sq) {
+int pieceMobility(evalInfo *ei, const Board *pos, int side, int pce, int sq) {
 
-    int index, t_sq, ksq, mobility = 0, att = 0;
-
-    ksq = FR2SQ(clamp(FilesBrd[pos->KingSq[!side]], FILE_B, FILE_G),
-                clamp(RanksBrd[pos->KingSq[!side]], RANK_2, RANK_7));
-
-    for (index = 0; index < NumDir[pce]; ++index) {
-        t_sq = sq + PceDir[pce][index];
-
-        if (  !SQOFFBOARD(t_sq)
-            && PieceCol[pos->pieces[t_sq]] != side) {
-
-            if (!pos->pawn_ctrl[!side][t_sq])
-                mobility++;
-
-            if (e.sqNearK[ksq][t_sq])
-                att++;
-        }
-    }
+    // Squares reached by the piece, not holding one of our own pieces
+    uint64_t attacks = pieceAttacks(pce, SQ64(sq), pos->colourBB[COLOUR_NB]) & ~pos->colourBB[side];
+    int att = popcount(attacks & ei->kingAreas[!side]);
 
     if (att) {
-        ei.attCnt[side] += att;
-        ei.attckersCnt[side] += 1;
-        ei.attWeight[side] += Weight[pce];
+        ei->attCnt[side] += att;
+        ei->attckersCnt[side] += 1;
+        ei->attWeight[side] += Weight[pce];
     }
 
-    return mobility;
-}
-
-int SlideMob(const Board *pos, int side, int pce, int sq) {
-
-    int index, t_sq, ksq, mobility = 0, att = 0;
-
-    ksq = FR2SQ(clamp(FilesBrd[pos->KingSq[!side]], FILE_B, FILE_G),
-                clamp(RanksBrd[pos->KingSq[!side]], RANK_2, RANK_7));
-
-    for (index = 0; index < NumDir[pce]; ++index) {
-        t_sq = sq + PceDir[pce][index];
-
-        while (!SQOFFBOARD(t_sq)) {
-
-            if (pos->pieces[t_sq] == EMPTY) {
-
-                if (!pos->pawn_ctrl[!side][t_sq])
-                    mobility++;
-
-                if (e.sqNearK[ksq][t_sq])
-                    att++;
-
-            } else { // non empty sq
-
-                if (PieceCol[pos->pieces[t_sq]] != side) { // opponent's piece
-
-                    if (!pos->pawn_ctrl[!side][t_sq])
-                        mobility++;
-
-                    if (e.sqNearK[ksq][t_sq])
-                        att++;
-                }
-                break;
-            }
-            t_sq += PceDir[pce][index];   
-        }
-    }
-
-    if (att) {
-        ei.attCnt[side] += att;
-        ei.attckersCnt[side] += 1;
-        ei.attWeight[side] += Weight[pce];
-    }
-
-    return mobility;
+    // Mobility ignores the squares controlled by enemy pawns
+    return popcount(attacks & ~ei->pe->attacks[!side]);
 }
 
 #define S(mg, eg) (makeScore((mg), (eg)))
@@ -370,10 +313,10 @@ const int ComplexityAdjustment  = S(   0,-117);
 
 #undef S
 
-int Pawns(const Board *pos, int side, int pce, int pceNum) {
+int Pawns(Pawn_Entry *pe, const Board *pos, int side, int pce, int pceNum) {
 
-    int score = 0, bonus, support, pawnbrothers;
-    int sq, t_sq, ksq, blockSq, w, R, Su, Up;
+    int score = 0, support, pawnbrothers;
+    int sq, R, Su, Up;
     uint64_t opposed;
 
     sq = pos->pList[pce][pceNum];
@@ -383,16 +326,9 @@ int Pawns(const Board *pos, int side, int pce, int pceNum) {
     if (TRACE) T.PawnValue[side]++;
     if (TRACE) T.PawnPSQT32[relativeSquare32(side, SQ64(sq))][side]++;
 
-    ksq = FR2SQ(clamp(FilesBrd[pos->KingSq[!side]], FILE_B, FILE_G),
-                clamp(RanksBrd[pos->KingSq[!side]], RANK_2, RANK_7));
-
-    for (int index = 0; index < NumDir[pce]; ++index) {
-        t_sq = sq + PceDir[pce][index];
-
-        if (  !SQOFFBOARD(t_sq)
-            && e.sqNearK[ksq][t_sq])
-            ei.attCnt[side]++;
-    }
+    // Squares attacked twice are counted twice against the King zone
+    pe->attacks2[side] |= pe->attacks[side] & pawnAttacks(side, SQ64(sq));
+    pe->attacks[side]  |= pawnAttacks(side, SQ64(sq));
 
     R  = relativeRank(side, SQ64(sq));
     Su = side == WHITE ? -10 :  10;
@@ -440,7 +376,7 @@ int Pawns(const Board *pos, int side, int pce, int pceNum) {
 
     if (!(PassedPawnMasks[side][SQ64(sq)] & pos->pawns[side^1])) {
         //printf("%c Passed:%s\n",PceChar[pce], PrSq(sq));
-        ei.passedCnt++;
+        setBit(&pe->passed, SQ64(sq));
         score += PawnPassed[R];
         if (TRACE) T.PawnPassed[R][side]++;
 
@@ -449,6 +385,53 @@ int Pawns(const Board *pos, int side, int pce, int pceNum) {
             score += PawnPassedConnected[R];
             if (TRACE) T.PawnPassedConnected[R][side]++;
         }
+    }
+
+    if (support || pawnbrothers) {
+        int i =  Connected[R] * (2 + (bool)(pawnbrothers) - (bool)(opposed))
+                + 30 * support;
+
+        i = (i * 100) / 1220;
+
+        if (TRACE) T.PawnConnected[R][side] += (2 + (bool)(pawnbrothers) - (bool)(opposed));
+        if (TRACE) T.PawnSupport[side] += support;
+        
+        //printf("supportCount %d v %d v eg %d R %d\n",support, i, i * (R - 2) / 4, R);
+        score += makeScore(i, i * (R - 2) / 4);
+    }
+    //ei->pawns[side] += score;
+
+    return score;
+}
+
+void evaluatePawns(Pawn_Entry *pe, const Board *pos) {
+
+    int pceNum;
+
+    // Everything here only depends on the placement of the pawns,
+    // which allows the result to be stored in the Pawn Hash Table
+
+    for (pceNum = 0; pceNum < pos->pceNum[wP]; ++pceNum)
+        pe->eval += Pawns(pe, pos, WHITE, wP, pceNum);
+
+    for (pceNum = 0; pceNum < pos->pceNum[bP]; ++pceNum)
+        pe->eval -= Pawns(pe, pos, BLACK, bP, pceNum);
+}
+
+int evaluatePassers(evalInfo *ei, const Board *pos, int side) {
+
+    int score = 0, bonus, sq, blockSq, w, R, Up;
+    uint64_t passers = ei->pe->passed & pos->pawns[side];
+
+    Up = side == WHITE ? 10 : -10;
+
+    // Bonus the advanced passed pawns by the distance of both Kings
+    // to the squares in front, these terms can't be hashed by pawns
+
+    while (passers) {
+
+        sq = SQ120(poplsb(&passers));
+        R  = relativeRank(side, SQ64(sq));
 
         if (R > RANK_3) {
 
@@ -471,24 +454,10 @@ int Pawns(const Board *pos, int side, int pce, int pceNum) {
         }
     }
 
-    if (support || pawnbrothers) {
-        int i =  Connected[R] * (2 + (bool)(pawnbrothers) - (bool)(opposed))
-                + 30 * support;
-
-        i = (i * 100) / 1220;
-
-        if (TRACE) T.PawnConnected[R][side] += (2 + (bool)(pawnbrothers) - (bool)(opposed));
-        if (TRACE) T.PawnSupport[side] += support;
-        
-        //printf("supportCount %d v %d v eg %d R %d\n",support, i, i * (R - 2) / 4, R);
-        score += makeScore(i, i * (R - 2) / 4);
-    }
-    //ei.pawns[side] += score;
-
     return score;
 }
 
-int Knights(const Board *pos, int side, int pce, int pceNum) {
+int Knights(evalInfo *ei, const Board *pos, int side, int pce, int pceNum) {
 
     int score = 0, mobility, tropism;
     int defended, Count, sq, R, P1, P2;
@@ -516,8 +485,8 @@ int Knights(const Board *pos, int side, int pce, int pceNum) {
     score += tropism * KnightTropism;
     if (TRACE) T.KnightTropism[side] += tropism;
 
-    mobility = NonSlideMob(pos, side, pce, sq);
-    ei.Mob[side] += KnightMobility[mobility];
+    mobility = pieceMobility(ei, pos, side, pce, sq);
+    ei->Mob[side] += KnightMobility[mobility];
     if (TRACE) T.KnightMobility[mobility][side]++;
 
     Count = distanceBetween(sq, pos->KingSq[side]);
@@ -526,12 +495,12 @@ int Knights(const Board *pos, int side, int pce, int pceNum) {
     score += makeScore(-P1, -P2);
     if (TRACE) T.KnightDefender[side] += Count;
 
-    //ei.knights[side] += score;
+    //ei->knights[side] += score;
 
     return score;   
 }
 
-int Bishops(const Board *pos, int side, int pce, int pceNum) {
+int Bishops(evalInfo *ei, const Board *pos, int side, int pce, int pceNum) {
 
     int score = 0, mobility, tropism;
     int defended, Count, sq, R, P1, P2;
@@ -559,8 +528,8 @@ int Bishops(const Board *pos, int side, int pce, int pceNum) {
     score += tropism * BishopTropism;
     if (TRACE) T.BishopTropism[side] += tropism;
 
-    mobility = SlideMob(pos, side, pce, sq);
-    ei.Mob[side] += BishopMobility[mobility];
+    mobility = pieceMobility(ei, pos, side, pce, sq);
+    ei->Mob[side] += BishopMobility[mobility];
     if (TRACE) T.BishopMobility[mobility][side]++;
 
     if (mobility <= 3) {
@@ -578,12 +547,12 @@ int Bishops(const Board *pos, int side, int pce, int pceNum) {
     score += makeScore(-P1, -P2);
     if (TRACE) T.BishopDefender[side] += Count;
   
-    //ei.bishops[side] += score;
+    //ei->bishops[side] += score;
 
     return score;
 }
 
-int Rooks(const Board *pos, int side, int pce, int pceNum) {
+int Rooks(evalInfo *ei, const Board *pos, int side, int pce, int pceNum) {
 
     int score = 0, mobility, tropism, sq, R, KR;
 
@@ -614,16 +583,16 @@ int Rooks(const Board *pos, int side, int pce, int pceNum) {
     score += tropism * RookTropism;
     if (TRACE) T.RookTropism[side] += tropism;
 
-    mobility = SlideMob(pos, side, pce, sq);
-    ei.Mob[side] += RookMobility[mobility];
+    mobility = pieceMobility(ei, pos, side, pce, sq);
+    ei->Mob[side] += RookMobility[mobility];
     if (TRACE) T.RookMobility[mobility][side]++;
 
-    //ei.rooks[side] += score;
+    //ei->rooks[side] += score;
 
     return score;
 }
 
-int Queens(const Board *pos, int side, int pce, int pceNum) {
+int Queens(evalInfo *ei, const Board *pos, int side, int pce, int pceNum) {
 
     int score = 0, mobility, tropism, sq, Knight, Bishop;
 
@@ -664,11 +633,11 @@ int Queens(const Board *pos, int side, int pce, int pceNum) {
     score += tropism * QueenTropism;
     if (TRACE) T.QueenTropism[side] += tropism;
 
-    mobility = SlideMob(pos, side, pce, sq);
-    ei.Mob[side] += QueenMobility[mobility];
+    mobility = pieceMobility(ei, pos, side, pce, sq);
+    ei->Mob[side] += QueenMobility[mobility];
     if (TRACE) T.QueenMobility[mobility][side]++;
 
-    //ei.queens[side] += score;
+    //ei->queens[side] += score;
 
     return score;
 }
@@ -704,7 +673,17 @@ int hypotheticalShelter(const Board *pos, int side, int KingSq) {
     return score;
 }
 
-int evaluateShelter(const Board *pos, int side) {
+int evaluateShelter(evalInfo *ei, const Board *pos, int side) {
+
+    Pawn_Entry *pe = ei->pe;
+    int castling = pos->castlePerm & (side == WHITE ? WKCA | WQCA : BKCA | BQCA);
+
+    // The shelter only changes with the King square or the castling
+    // rights once the pawns are fixed, so reuse the one we've cached
+    if (   !TRACE
+        &&  pe->kingSq[side] == pos->KingSq[side]
+        &&  pe->castling[side] == castling)
+        return ei->pkeval[side] = pe->shelter[side];
 
     int shelter = hypotheticalShelter(pos, side, pos->KingSq[side]);
 
@@ -723,12 +702,14 @@ int evaluateShelter(const Board *pos, int side) {
         if (pos->castlePerm & BQCA) 
             shelter = MAX(shelter, hypotheticalShelter(pos, side, C8));
     }
-    ei.pkeval[side] = shelter;
+    ei->pkeval[side] = pe->shelter[side] = shelter;
+    pe->kingSq[side] = pos->KingSq[side];
+    pe->castling[side] = castling;
 
     return shelter;
 }
 
-int evaluateKings(const Board *pos, int side) {
+int evaluateKings(evalInfo *ei, const Board *pos, int side) {
 
     int score = 0, count, enemyQueen;
 
@@ -741,76 +722,70 @@ int evaluateKings(const Board *pos, int side) {
         if (TRACE) T.KingPawnLessFlank[side]++;
     }
 
-    score += evaluateShelter(pos, side);
+    score += evaluateShelter(ei, pos, side);
 
-    if (ei.attckersCnt[side^1] > 1 - pos->pceNum[enemyQueen]) {
+    if (ei->attckersCnt[side^1] > 1 - pos->pceNum[enemyQueen]) {
 
-        float scaledAttackCounts = 9.0 * ei.attCnt[side^1] / popcount(ei.kingAreas[side]);
+        float scaledAttackCounts = 9.0 * ei->attCnt[side^1] / popcount(ei->kingAreas[side]);
 
         count =  32 * scaledAttackCounts
-               +      ei.attckersCnt[side^1] * ei.attWeight[side^1]
-               +      mgScore(ei.Mob[side^1] - ei.Mob[side]) / 4
-               -  6 * mgScore(ei.pkeval[side]) / 8
+               +      ei->attckersCnt[side^1] * ei->attWeight[side^1]
+               +      mgScore(ei->Mob[side^1] - ei->Mob[side]) / 4
+               -  6 * mgScore(ei->pkeval[side]) / 8
                - 17 ;
 
         if (count > 26) {
             score -= makeScore(count * count / 720, count / 18);
-            //ei.KingDanger[side^1] = makeScore(count * count / 720, count / 18);
+            //ei->KingDanger[side^1] = makeScore(count * count / 720, count / 18);
         }
     }
 
     return score;
 }
 
-int evaluatePieces(const Board *pos) {
-    int pce, pceNum, score = 0;
-    pce = wP;
-    for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score += Pawns(pos, WHITE, pce, pceNum);
-    }
-    pce = bP;
-    for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score -= Pawns(pos, BLACK, pce, pceNum);
-    }
+int evaluatePieces(evalInfo *ei, const Board *pos) {
+    int pce, pceNum, score = ei->pe->eval;
+    score += evaluatePassers(ei, pos, WHITE);
+    score -= evaluatePassers(ei, pos, BLACK);
     pce = wN;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score += Knights(pos, WHITE, pce, pceNum);
+        score += Knights(ei, pos, WHITE, pce, pceNum);
     }
     pce = bN;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score -= Knights(pos, BLACK, pce, pceNum);
+        score -= Knights(ei, pos, BLACK, pce, pceNum);
     }
     pce = wB;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score += Bishops(pos, WHITE, pce, pceNum);
+        score += Bishops(ei, pos, WHITE, pce, pceNum);
     }
     pce = bB;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score -= Bishops(pos, BLACK, pce, pceNum);
+        score -= Bishops(ei, pos, BLACK, pce, pceNum);
     }
     pce = wR;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score += Rooks(pos, WHITE, pce, pceNum);
+        score += Rooks(ei, pos, WHITE, pce, pceNum);
     }
     pce = bR;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score -= Rooks(pos, BLACK, pce, pceNum);
+        score -= Rooks(ei, pos, BLACK, pce, pceNum);
     }
     pce = wQ;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score += Queens(pos, WHITE, pce, pceNum);
+        score += Queens(ei, pos, WHITE, pce, pceNum);
     }
     pce = bQ;
     for(pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-        score -= Queens(pos, BLACK, pce, pceNum);
+        score -= Queens(ei, pos, BLACK, pce, pceNum);
     }
-    score += evaluateKings(pos, WHITE);
-    score -= evaluateKings(pos, BLACK);
+    score += evaluateKings(ei, pos, WHITE);
+    score -= evaluateKings(ei, pos, BLACK);
 
     return score;
 }
 
-int evaluateComplexity(const Board *pos, int score) {
+int evaluateComplexity(evalInfo *ei, const Board *pos, int score) {
 
     int complexity, outflanking, pawnsOnBothFlanks, pawnEndgame, almostUnwinnable, sign, eg, v;
 
@@ -826,11 +801,11 @@ int evaluateComplexity(const Board *pos, int score) {
     pawnEndgame =   (!pos->pceNum[wN] && !pos->pceNum[wB] && !pos->pceNum[wR] && !pos->pceNum[wQ])
                  && (!pos->pceNum[bN] && !pos->pceNum[bB] && !pos->pceNum[bR] && !pos->pceNum[bQ]);
 
-    almostUnwinnable =   !ei.passedCnt
+    almostUnwinnable =   !ei->passedCnt
                       && !pawnsOnBothFlanks
                       &&  outflanking < 0;
 
-    complexity =  ComplexityPassedPawns * ei.passedCnt
+    complexity =  ComplexityPassedPawns * ei->passedCnt
                 + ComplexityTotalPawns  * popcount(pos->pawns[COLOUR_NB])
                 + ComplexityOutflanking * outflanking
                 + ComplexityPawnFlanks  * pawnsOnBothFlanks
@@ -838,7 +813,7 @@ int evaluateComplexity(const Board *pos, int score) {
                 + ComplexityUnwinnable  * almostUnwinnable
                 + ComplexityAdjustment  ;
 
-    if (TRACE) T.ComplexityPassedPawns[WHITE] += sign * ei.passedCnt;
+    if (TRACE) T.ComplexityPassedPawns[WHITE] += sign * ei->passedCnt;
     if (TRACE) T.ComplexityTotalPawns[WHITE]  += sign * popcount(pos->pawns[COLOUR_NB]);
     if (TRACE) T.ComplexityOutflanking[WHITE] += sign * outflanking;
     if (TRACE) T.ComplexityPawnFlanks[WHITE]  += sign * pawnsOnBothFlanks;
@@ -848,7 +823,7 @@ int evaluateComplexity(const Board *pos, int score) {
 
     v = sign * MAX(egScore(complexity), -abs(eg));
 
-    //ei.Complexity = makeScore(0, v);
+    //ei->Complexity = makeScore(0, v);
 
     return makeScore(0, v);
 }
@@ -876,7 +851,7 @@ int imbalance(const int pieceCount[2][6], int side) {
         u += pieceCount[side][pt1] * mgScore(w);
         v += pieceCount[side][pt1] * egScore(w);
     }
-    //ei.imbalance[side] = makeScore(u / 16, v / 16);
+    //ei->imbalance[side] = makeScore(u / 16, v / 16);
 
     return makeScore(u / 16, v / 16);
 }
@@ -916,7 +891,7 @@ int evaluateScaleFactor(const Board *pos, int egScore) {
     return SCALE_NORMAL;
 }
 
-void blockedPiecesW(const Board *pos) {
+void blockedPiecesW(evalInfo *ei, const Board *pos) {
 
     int side = WHITE;
 
@@ -924,36 +899,36 @@ void blockedPiecesW(const Board *pos) {
     if (pos->pieces[C1] == wB
     &&  pos->pieces[D2] == wP
     && pos->pieces[D3] != EMPTY) {
-       ei.blockages[side] -= P_BLOCK_CENTRAL_PAWN;
+       ei->blockages[side] -= P_BLOCK_CENTRAL_PAWN;
     }
 
     if (pos->pieces[F1] == wB
     && pos->pieces[E2] == wP
     && pos->pieces[E3] != EMPTY) {
-       ei.blockages[side] -= P_BLOCK_CENTRAL_PAWN;
+       ei->blockages[side] -= P_BLOCK_CENTRAL_PAWN;
     }
 
     // trapped knight
     if ( pos->pieces[A8] == wN
     &&  ( pos->pieces[A7] == bP || pos->pieces[C7] == bP) ) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A8;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A8;
     }
 
     if ( pos->pieces[H8] == wN
     && ( pos->pieces[H7] == bP || pos->pieces[F7] == bP)) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A8;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A8;
     }
 
     if (pos->pieces[A7] == wN
     &&  pos->pieces[A6] == bP
     &&  pos->pieces[B7] == bP) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A7;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A7;
     }
 
     if (pos->pieces[H7] == wN
     &&  pos->pieces[H6] == bP
     &&  pos->pieces[G7] == bP) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A7;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A7;
     }
 
      // knight blocking queenside pawns
@@ -961,66 +936,66 @@ void blockedPiecesW(const Board *pos) {
     &&  pos->pieces[C2] == wP
     && (pos->pieces[D4] == wP || pos->pieces[D2] == wP)
     &&  pos->pieces[E4] != wP) {
-        ei.blockages[side] -= P_C3_KNIGHT;
+        ei->blockages[side] -= P_C3_KNIGHT;
     }
 
      // trapped bishop
     if (pos->pieces[A7] == wB
     &&  pos->pieces[B6] == bP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[H7] == wB
     &&  pos->pieces[G6] == bP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[B8] == wB
     &&  pos->pieces[C7] == bP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[G8] == wB
     &&  pos->pieces[F7] == bP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[A6] == wB
     &&  pos->pieces[B5] == bP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A6;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A6;
     }
 
     if (pos->pieces[H6] == wB
     &&  pos->pieces[G5] == bP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A6;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A6;
     }
 
      // bishop on initial square supporting castled king
     if (pos->pieces[F1] == wB
     &&  pos->pieces[G1] == wK) {
-        ei.blockages[side] += RETURNING_BISHOP;
+        ei->blockages[side] += RETURNING_BISHOP;
     }
 
     if (pos->pieces[C1] == wB
     &&  pos->pieces[B1] == wK) {
-        ei.blockages[side] += RETURNING_BISHOP;
+        ei->blockages[side] += RETURNING_BISHOP;
     }
 
     // uncastled king blocking own rook
     if ( (pos->pieces[F1] == wK || pos->pieces[G1] == wK)
     &&  (pos->pieces[H1] == wR || pos->pieces[G1] == wR)) {
     //&& (pos->pieces[F2] == wP || pos->pieces[G2] == wP || pos->pieces[H2] == wP)) {
-        ei.blockages[side] -= P_KING_BLOCKS_ROOK;
+        ei->blockages[side] -= P_KING_BLOCKS_ROOK;
     }
 
     if ( (pos->pieces[C1] == wK || pos->pieces[B1] == wK)
     &&  (pos->pieces[A1] == wR || pos->pieces[B1] == wR)) {
     //&& (pos->pieces[F2] == wP || pos->pieces[G2] == wP || pos->pieces[H2] == wP)) {
-        ei.blockages[side] -= P_KING_BLOCKS_ROOK;
+        ei->blockages[side] -= P_KING_BLOCKS_ROOK;
     }
 }
 
-void blockedPiecesB(const Board *pos) {
+void blockedPiecesB(evalInfo *ei, const Board *pos) {
 
     int side = BLACK;
 
@@ -1028,36 +1003,36 @@ void blockedPiecesB(const Board *pos) {
     if (pos->pieces[C8] == bB
     &&  pos->pieces[D7] == bP
     && pos->pieces[D6] != EMPTY) {
-       ei.blockages[side] -= P_BLOCK_CENTRAL_PAWN;
+       ei->blockages[side] -= P_BLOCK_CENTRAL_PAWN;
     }
 
     if (pos->pieces[F8] == bB
     && pos->pieces[E7] == bP
     && pos->pieces[E6] != EMPTY) {
-       ei.blockages[side] -= P_BLOCK_CENTRAL_PAWN;
+       ei->blockages[side] -= P_BLOCK_CENTRAL_PAWN;
     }
 
     // trapped knight
     if ( pos->pieces[A1] == bN
     && ( pos->pieces[A2] == wP || pos->pieces[C2] == wP)) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A8;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A8;
     }
 
     if ( pos->pieces[H1] == bN
     && ( pos->pieces[H2] == wP || pos->pieces[F2] == wP)) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A8;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A8;
     }
 
     if (pos->pieces[A2] == bN
     &&  pos->pieces[A3] == wP
     &&  pos->pieces[B2] == wP) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A7;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A7;
     }
 
     if (pos->pieces[H2] == bN
     &&  pos->pieces[H3] == wP
     &&  pos->pieces[G2] == wP) {
-        ei.blockages[side] -= P_KNIGHT_TRAPPED_A7;
+        ei->blockages[side] -= P_KNIGHT_TRAPPED_A7;
     }
 
      // knight blocking queenside pawns
@@ -1065,77 +1040,78 @@ void blockedPiecesB(const Board *pos) {
     &&  pos->pieces[C7] == bP
     && (pos->pieces[D5] == bP || pos->pieces[D7] == bP)
     &&  pos->pieces[E5] != bP) {
-        ei.blockages[side] -= P_C3_KNIGHT;
+        ei->blockages[side] -= P_C3_KNIGHT;
     }
 
      // trapped bishop
     if (pos->pieces[A2] == bB
     &&  pos->pieces[B3] == wP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[H2] == bB
     &&  pos->pieces[G3] == wP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[B1] == bB
     &&  pos->pieces[C2] == wP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[G1] == bB
     &&  pos->pieces[F2] == wP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A7;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A7;
     }
 
     if (pos->pieces[A3] == bB
     &&  pos->pieces[B4] == wP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A6;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A6;
     }
 
     if (pos->pieces[H3] == bB
     &&  pos->pieces[G4] == wP) {
-        ei.blockages[side] -= P_BISHOP_TRAPPED_A6;
+        ei->blockages[side] -= P_BISHOP_TRAPPED_A6;
     }
 
      // bishop on initial square supporting castled king
     if (pos->pieces[F8] == bB
     &&  pos->pieces[G8] == bK) {
-        ei.blockages[side] += RETURNING_BISHOP;
+        ei->blockages[side] += RETURNING_BISHOP;
     }
 
     if (pos->pieces[C8] == bB
     &&  pos->pieces[B8] == bK) {
-        ei.blockages[side] += RETURNING_BISHOP;
+        ei->blockages[side] += RETURNING_BISHOP;
     }
 
     // uncastled king blocking own rook
     if ((pos->pieces[F8] == bK || pos->pieces[G8] == bK)
     && (pos->pieces[H8] == bR || pos->pieces[G8] == bR)) {
     //&& (pos->pieces[F7] == bP || pos->pieces[G7] == bP || pos->pieces[H7] == bP)) {
-        ei.blockages[side] -= P_KING_BLOCKS_ROOK;
+        ei->blockages[side] -= P_KING_BLOCKS_ROOK;
     }
 
     if ((pos->pieces[C8] == bK || pos->pieces[B8] == bK)
     && (pos->pieces[A8] == bR || pos->pieces[B8] == bR)) { 
     //&& (pos->pieces[F7] == bP || pos->pieces[G7] == bP || pos->pieces[H7] == bP)) {
-        ei.blockages[side] -= P_KING_BLOCKS_ROOK;
+        ei->blockages[side] -= P_KING_BLOCKS_ROOK;
     }
 }
 
-int EvalPosition(const Board *pos, Material_Table *materialTable) {
+int EvalPosition(const Board *pos, Thread *thread) {
     // setboard 8/3k3p/6p1/3nK1P1/8/8/7P/8 b - - 3 64
     // setboard r2q1rk1/p2b1p1p/1p1b2pQ/2p1pP2/1nPp4/1P1BP3/PB1P2PP/RN3RK1 w - - 1 16
     // setboard 8/6R1/2k5/6P1/8/8/4nP2/6K1 w - - 1 41 
 
     int eval, factor, s1, s2;
-    Material_Entry* me = Material_probe(pos, materialTable);
+    evalInfo *const ei = &thread->ei;
+    Material_Entry* me = Material_probe(pos, &thread->materialTable);
 
     if (me->evalExists)
         return me->eval;
 
-    memset(&ei, 0, sizeof(evalInfo));
+    memset(ei, 0, sizeof(evalInfo));
 
     s1 = makeSq(clamp(FilesBrd[pos->KingSq[WHITE]], FILE_B, FILE_G),
                 clamp(RanksBrd[pos->KingSq[WHITE]], RANK_2, RANK_7));
@@ -1143,18 +1119,27 @@ int EvalPosition(const Board *pos, Material_Table *materialTable) {
     s2 = makeSq(clamp(FilesBrd[pos->KingSq[BLACK]], FILE_B, FILE_G),
                 clamp(RanksBrd[pos->KingSq[BLACK]], RANK_2, RANK_7));
 
-    ei.kingAreas[WHITE] = kingAreaMasks(s1);
-    ei.kingAreas[BLACK] = kingAreaMasks(s2);
+    ei->kingAreas[WHITE] = kingAreaMasks(s1);
+    ei->kingAreas[BLACK] = kingAreaMasks(s2);
+
+    ei->pe = Pawn_probe(pos, &thread->pawnTable);
+    ei->passedCnt = popcount(ei->pe->passed);
+
+    // Pawn attacks towards the enemy King zone, from the cached maps
+    ei->attCnt[WHITE] =  popcount(ei->pe->attacks [WHITE] & ei->kingAreas[BLACK])
+                       + popcount(ei->pe->attacks2[WHITE] & ei->kingAreas[BLACK]);
+    ei->attCnt[BLACK] =  popcount(ei->pe->attacks [BLACK] & ei->kingAreas[WHITE])
+                       + popcount(ei->pe->attacks2[BLACK] & ei->kingAreas[WHITE]);
 
     eval  = pos->mPhases[WHITE] - pos->mPhases[BLACK];
     eval += pos->PSQT[WHITE] - pos->PSQT[BLACK];
-    eval += ei.Mob[WHITE] - ei.Mob[BLACK];
+    eval += ei->Mob[WHITE] - ei->Mob[BLACK];
     eval += me->imbalance;
-    eval += evaluatePieces(pos);
-    eval += evaluateComplexity(pos, eval);
+    eval += evaluatePieces(ei, pos);
+    eval += evaluateComplexity(ei, pos, eval);
 
-    blockedPiecesW(pos);
-    blockedPiecesB(pos);
+    blockedPiecesW(ei, pos);
+    blockedPiecesB(ei, pos);
 
     factor = me->factor != SCALE_NORMAL
            ? me->factor : evaluateScaleFactor(pos, egScore(eval));
@@ -1162,7 +1147,7 @@ int EvalPosition(const Board *pos, Material_Table *materialTable) {
     eval = (mgScore(eval) * (256 - me->gamePhase)
           +  egScore(eval) * me->gamePhase * factor / SCALE_NORMAL) / 256;
 
-    eval += ei.blockages[WHITE] - ei.blockages[BLACK];
+    eval += ei->blockages[WHITE] - ei->blockages[BLACK];
 
     eval += pos->side == WHITE ? TEMPO : -TEMPO;
 
@@ -1177,9 +1162,11 @@ void printEvalFactor( int WMG, int WEG, int BMG, int BEG ) {
     printf("| %4d  %4d  | %4d  %4d  | %4d  %4d \n",WMG, WEG, BMG, BEG, WMG - BMG, WEG - BEG );
 }
 
-void printEval(const Board *pos) {
+void printEval(const Board *pos, Thread *thread) {
+
+    evalInfo *const ei = &thread->ei;
 
-    int v = EvalPosition(pos, &Table);
+    int v = EvalPosition(pos, thread);
     v = pos->side == WHITE ? v : -v;
 
     printf("\n");
@@ -1187,17 +1174,17 @@ void printEval(const Board *pos) {
     printf("              |   MG    EG  |   MG    EG  |   MG    EG \n");
     printf("--------------+-------------+-------------+------------\n");
     printf("     Material "); printEvalFactor( mgScore(pos->mPhases[WHITE]),egScore(pos->mPhases[WHITE]),mgScore(pos->mPhases[BLACK]),egScore(pos->mPhases[BLACK]));
-    printf("    Imbalance "); printEvalFactor( mgScore(ei.imbalance[WHITE]),egScore(ei.imbalance[WHITE]),mgScore(ei.imbalance[BLACK]),egScore(ei.imbalance[BLACK]));
+    printf("    Imbalance "); printEvalFactor( mgScore(ei->imbalance[WHITE]),egScore(ei->imbalance[WHITE]),mgScore(ei->imbalance[BLACK]),egScore(ei->imbalance[BLACK]));
     printf("         PSQT "); printEvalFactor( mgScore(pos->PSQT[WHITE]),egScore(pos->PSQT[WHITE]),mgScore(pos->PSQT[BLACK]),egScore(pos->PSQT[BLACK]));
-    printf("        Pawns "); printEvalFactor( mgScore(ei.pawns[WHITE]),egScore(ei.pawns[WHITE]),mgScore(ei.pawns[BLACK]),egScore(ei.pawns[BLACK]));
-    printf("      Knights "); printEvalFactor( mgScore(ei.knights[WHITE]),egScore(ei.knights[WHITE]),mgScore(ei.knights[BLACK]),egScore(ei.knights[BLACK]));
-    printf("      Bishops "); printEvalFactor( mgScore(ei.bishops[WHITE]),egScore(ei.bishops[WHITE]),mgScore(ei.bishops[BLACK]),egScore(ei.bishops[BLACK]));
-    printf("        Rooks "); printEvalFactor( mgScore(ei.rooks[WHITE]),egScore(ei.rooks[WHITE]),mgScore(ei.rooks[BLACK]),egScore(ei.rooks[BLACK]));
-    printf("       Queens "); printEvalFactor( mgScore(ei.queens[WHITE]),egScore(ei.queens[WHITE]),mgScore(ei.queens[BLACK]),egScore(ei.queens[BLACK]));
-    printf("     Mobility "); printEvalFactor( mgScore(ei.Mob[WHITE]),egScore(ei.Mob[WHITE]),mgScore(ei.Mob[BLACK]),egScore(ei.Mob[BLACK]));
-    printf("  King safety "); printEvalFactor( mgScore(ei.KingDanger[WHITE]),egScore(ei.KingDanger[WHITE]),mgScore(ei.KingDanger[BLACK]),egScore(ei.KingDanger[BLACK]));
-    printf("  King shield "); printEvalFactor( mgScore(ei.pkeval[WHITE]),egScore(ei.pkeval[WHITE]),mgScore(ei.pkeval[BLACK]),egScore(ei.pkeval[BLACK]));
-    printf("   Initiative "); printf("| ----  ----  | ----  ----  | %4d  %4d \n", mgScore(ei.Complexity), egScore(ei.Complexity));
+    printf("        Pawns "); printEvalFactor( mgScore(ei->pawns[WHITE]),egScore(ei->pawns[WHITE]),mgScore(ei->pawns[BLACK]),egScore(ei->pawns[BLACK]));
+    printf("      Knights "); printEvalFactor( mgScore(ei->knights[WHITE]),egScore(ei->knights[WHITE]),mgScore(ei->knights[BLACK]),egScore(ei->knights[BLACK]));
+    printf("      Bishops "); printEvalFactor( mgScore(ei->bishops[WHITE]),egScore(ei->bishops[WHITE]),mgScore(ei->bishops[BLACK]),egScore(ei->bishops[BLACK]));
+    printf("        Rooks "); printEvalFactor( mgScore(ei->rooks[WHITE]),egScore(ei->rooks[WHITE]),mgScore(ei->rooks[BLACK]),egScore(ei->rooks[BLACK]));
+    printf("       Queens "); printEvalFactor( mgScore(ei->queens[WHITE]),egScore(ei->queens[WHITE]),mgScore(ei->queens[BLACK]),egScore(ei->queens[BLACK]));
+    printf("     Mobility "); printEvalFactor( mgScore(ei->Mob[WHITE]),egScore(ei->Mob[WHITE]),mgScore(ei->Mob[BLACK]),egScore(ei->Mob[BLACK]));
+    printf("  King safety "); printEvalFactor( mgScore(ei->KingDanger[WHITE]),egScore(ei->KingDanger[WHITE]),mgScore(ei->KingDanger[BLACK]),egScore(ei->KingDanger[BLACK]));
+    printf("  King shield "); printEvalFactor( mgScore(ei->pkeval[WHITE]),egScore(ei->pkeval[WHITE]),mgScore(ei->pkeval[BLACK]),egScore(ei->pkeval[BLACK]));
+    printf("   Initiative "); printf("| ----  ----  | ----  ----  | %4d  %4d \n", mgScore(ei->Complexity), egScore(ei->Complexity));
     printf("--------------+-------------+-------------+------------\n");
     printf("        Total "); printf("| ----  ----  | ----  ----  | %4d cp: %d\n", v, to_cp(v));
     printf("\n");
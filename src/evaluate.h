@@ -96,6 +96,7 @@ struct EvalTrace {
 };
 
 struct evalInfo {
+    Pawn_Entry *pe;
     uint64_t kingAreas[COLOUR_NB];
     int Mob[COLOUR_NB];
     int attCnt[COLOUR_NB];
@@ -115,36 +116,36 @@ struct evalInfo {
 };
 
 struct evalData {
-    int sqNearK[120][120];
     int PSQT[13][120];
 };
 
 int to_cp(int v);
-void blockedPiecesW(const Board *pos);
-void blockedPiecesB(const Board *pos);
+void blockedPiecesW(evalInfo *ei, const Board *pos);
+void blockedPiecesB(evalInfo *ei, const Board *pos);
 void printEvalFactor( int WMG, int WEG, int BMG, int BEG );
-void printEval(const Board *pos);
+void printEval(const Board *pos, Thread *thread);
 void setPcsq32();
 bool opposite_bishops(const Board *pos);
 int pawns_on_same_color_squares(const Board *pos, const int colour, const int sq);
 int getTropism(const int s1, const int s2);
 int king_proximity(const int c, const int s, const Board *pos);
 int isPiece(const int piece, const int sq, const Board *pos);
-int NonSlideMob(const Board *pos, int side, int pce, int sq);
-int SlideMob(const Board *pos, int side, int pce, int sq);
+int pieceMobility(evalInfo *ei, const Board *pos, int side, int pce, int sq);
 int evaluateScaleFactor(const Board *pos, int egScore);
-int Pawns(const Board *pos, int side, int pce, int pceNum);
-int Knights(const Board *pos, int side, int pce, int pceNum);
-int Bishops(const Board *pos, int side, int pce, int pceNum);
-int Rooks(const Board *pos, int side, int pce, int pceNum);
-int Queens(const Board *pos, int side, int pce, int pceNum);
+int Pawns(Pawn_Entry *pe, const Board *pos, int side, int pce, int pceNum);
+void evaluatePawns(Pawn_Entry *pe, const Board *pos);
+int evaluatePassers(evalInfo *ei, const Board *pos, int side);
+int Knights(evalInfo *ei, const Board *pos, int side, int pce, int pceNum);
+int Bishops(evalInfo *ei, const Board *pos, int side, int pce, int pceNum);
+int Rooks(evalInfo *ei, const Board *pos, int side, int pce, int pceNum);
+int Queens(evalInfo *ei, const Board *pos, int side, int pce, int pceNum);
 int hypotheticalShelter(const Board *pos, int side, int KingSq);
-int evaluateShelter(const Board *pos, int side);
-int evaluateKings(const Board *pos, int side);
-int evaluatePieces(const Board *pos);
-int evaluateComplexity(const Board *pos, int score);
+int evaluateShelter(evalInfo *ei, const Board *pos, int side);
+int evaluateKings(evalInfo *ei, const Board *pos, int side);
+int evaluatePieces(evalInfo *ei, const Board *pos);
+int evaluateComplexity(evalInfo *ei, const Board *pos, int score);
 int imbalance(const int pieceCount[2][6], int side);
-int EvalPosition(const Board *pos, Material_Table *materialTable);
+int EvalPosition(const Board *pos, Thread *thread);
 
 #define ENDGAME_MAT (1 * PieceValue[EG][wR] + 2 * PieceValue[EG][wN] + 2 * PieceValue[EG][wP])
 #define makeScore(mg, eg) ((int)((unsigned int)(eg) << 16) + (mg))
@@ -98,3 +98,16 @@ uint64_t GenerateMaterialKey(const Board *pos) {
 	
 	return materialKey;
 }
+
+uint64_t GeneratePawnKey(const Board *pos) {
+
+	uint64_t pawnKey = 0;
+
+	for (int cnt = 0; cnt < pos->pceNum[wP]; ++cnt)
+		pawnKey ^= PieceKeys[wP][pos->pList[wP][cnt]];
+
+	for (int cnt = 0; cnt < pos->pceNum[bP]; ++cnt)
+		pawnKey ^= PieceKeys[bP][pos->pList[bP][cnt]];
+
+	return pawnKey;
+}
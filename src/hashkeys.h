@@ -29,8 +29,10 @@ void InitHashKeys();
 
 uint64_t GeneratePosKey(const Board *pos);
 uint64_t GenerateMaterialKey(const Board *pos);
+uint64_t GeneratePawnKey(const Board *pos);
 
 #define HASH_PCE(pce,sq) (pos->posKey ^= (PieceKeys[(pce)][(sq)]))
+#define HASH_PAWN(pce,sq) (pos->pawnKey ^= (PieceKeys[(pce)][(sq)]))
 #define HASH_CA (pos->posKey ^= (CastleKeys[(pos->castlePerm)]))
 #define HASH_SIDE (pos->posKey ^= (SideKey))
 #define HASH_EP (pos->posKey ^= (PieceKeys[EMPTY][(pos->enPas)]))
\ No newline at end of file
@@ -23,8 +23,12 @@
 #include "defs.h"
 #include "history.h"
 #include "makemove.h"
+#include "thread.h"
 
-void updateHistoryStats(Board *pos, SearchInfo *info, int *quiets, int quietsPlayed, int height, int bonus) {
+void updateHistoryStats(Thread *thread, int *quiets, int quietsPlayed, int height, int bonus) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
 
     int entry, colour = pos->side;
     int bestMove = quiets[quietsPlayed-1];
@@ -63,57 +67,60 @@ void updateHistoryStats(Board *pos, SearchInfo *info, int *quiets, int quietsPla
         int piece = pieceType(pos->pieces[SQ120(from)]);
 
         // Update Butterfly History
-        entry = pos->mainHistory[colour][from][to];
+        entry = thread->mainHistory[colour][from][to];
         entry += HistoryMultiplier * delta - entry * abs(delta) / HistoryDivisor;
-        pos->mainHistory[colour][from][to] = entry;
+        thread->mainHistory[colour][from][to] = entry;
 
         // Update Counter Move History
         if (counter != NONE_MOVE && counter != NULL_MOVE) {
-            entry = pos->continuation[0][cmPiece][cmTo][piece][to];
+            entry = thread->continuation[0][cmPiece][cmTo][piece][to];
             entry += HistoryMultiplier * delta - entry * abs(delta) / HistoryDivisor;
-            pos->continuation[0][cmPiece][cmTo][piece][to] = entry;
+            thread->continuation[0][cmPiece][cmTo][piece][to] = entry;
         }
 
         // Update Follow Move History
         if (follow != NONE_MOVE && follow != NULL_MOVE) {
-            entry = pos->continuation[1][fmPiece][fmTo][piece][to];
+            entry = thread->continuation[1][fmPiece][fmTo][piece][to];
             entry += HistoryMultiplier * delta - entry * abs(delta) / HistoryDivisor;
-            pos->continuation[1][fmPiece][fmTo][piece][to] = entry;
+            thread->continuation[1][fmPiece][fmTo][piece][to] = entry;
         }
 
         // Update Grandchild Move History
         if (grandchild != NONE_MOVE && grandchild != NULL_MOVE) {
-            entry = pos->continuation[1][gcmPiece][gcmTo][piece][to];
+            entry = thread->continuation[1][gcmPiece][gcmTo][piece][to];
             entry += HistoryMultiplier * delta - entry * abs(delta) / HistoryDivisor;
-            pos->continuation[1][gcmPiece][gcmTo][piece][to] = entry;
+            thread->continuation[1][gcmPiece][gcmTo][piece][to] = entry;
         }
 
         // Update Grandchildren Move History
         if (grandchildren != NONE_MOVE && grandchildren != NULL_MOVE) {
-            entry = pos->continuation[1][gchmPiece][gchmTo][piece][to];
+            entry = thread->continuation[1][gchmPiece][gchmTo][piece][to];
             entry += HistoryMultiplier * delta - entry * abs(delta) / HistoryDivisor;
-            pos->continuation[1][gchmPiece][gchmTo][piece][to] = entry;
+            thread->continuation[1][gchmPiece][gchmTo][piece][to] = entry;
         }
     }
 
     // Update Counter Moves (BestMove refutes the previous move)
     if (counter != NONE_MOVE && counter != NULL_MOVE)
-        pos->cmtable[!colour][cmPiece][cmTo] = bestMove;
+        thread->cmtable[!colour][cmPiece][cmTo] = bestMove;
 
     // Update Killer Moves (Avoid duplicates)
-    updateKillerMoves(pos, height, bestMove);
+    updateKillerMoves(thread, height, bestMove);
 }
 
-void updateKillerMoves(Board *pos, int height, int move) {
+void updateKillerMoves(Thread *thread, int height, int move) {
 
     // Update Killer Moves (Avoid duplicates)
-    if (pos->killers[height][0] != move) {
-        pos->killers[height][1] = pos->killers[height][0];
-        pos->killers[height][0] = move;
+    if (thread->killers[height][0] != move) {
+        thread->killers[height][1] = thread->killers[height][0];
+        thread->killers[height][0] = move;
     }
 }
 
-void getHistoryScore(Board *pos, SearchInfo *info, int move, int height, int *hist, int *cmhist, int *fmhist, int *gcmhist, int *gchmhist) {
+void getHistoryScore(Thread *thread, int move, int height, int *hist, int *cmhist, int *fmhist, int *gcmhist, int *gchmhist) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
 
     // Extract information from this move
     int to = SQ64(TOSQ(move));
@@ -141,26 +148,29 @@ void getHistoryScore(Board *pos, SearchInfo *info, int move, int height, int *hi
     int gchmTo = SQ64(TOSQ(grandchildren));
 
     // Set basic Butterfly history
-    *hist = pos->mainHistory[pos->side][from][to];
+    *hist = thread->mainHistory[pos->side][from][to];
 
     // Set Counter Move History if it exists
     if (counter == NONE_MOVE || counter == NULL_MOVE) *cmhist = 0;
-    else *cmhist = pos->continuation[0][cmPiece][cmTo][piece][to];
+    else *cmhist = thread->continuation[0][cmPiece][cmTo][piece][to];
 
     // Set Follow Move History if it exists
     if (follow == NONE_MOVE || follow == NULL_MOVE) *fmhist = 0;
-    else *fmhist = pos->continuation[1][fmPiece][fmTo][piece][to];
+    else *fmhist = thread->continuation[1][fmPiece][fmTo][piece][to];
 
     // Set Grandchild Move History if it exists
     if (grandchild == NONE_MOVE || grandchild == NULL_MOVE) *gcmhist = 0;
-    else *gcmhist = pos->continuation[1][gcmPiece][gcmTo][piece][to];
+    else *gcmhist = thread->continuation[1][gcmPiece][gcmTo][piece][to];
 
     // Set Grandchildren Move History if it exists
     if (grandchildren == NONE_MOVE || grandchildren == NULL_MOVE) *gchmhist = 0;
-    else *gchmhist = pos->continuation[1][gchmPiece][gchmTo][piece][to];
+    else *gchmhist = thread->continuation[1][gchmPiece][gchmTo][piece][to];
 }
 
-void scoreQuietMoves(Board *pos, SearchInfo *info, MoveList *list, int start, int length, int height) {
+void scoreQuietMoves(Thread *thread, MoveList *list, int start, int length, int height) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
 
     // Extract information from one move ago.
     int counter = info->currentMove[height-1];
@@ -190,27 +200,30 @@ void scoreQuietMoves(Board *pos, SearchInfo *info, MoveList *list, int start, in
         int piece = pieceType(pos->pieces[SQ120(from)]);
 
         // Start with the basic Butterfly history
-        list->moves[i].score = pos->mainHistory[pos->side][from][to];
+        list->moves[i].score = thread->mainHistory[pos->side][from][to];
 
         // Add Counter Move History if it exists
         if (counter != NONE_MOVE && counter != NULL_MOVE)
-            list->moves[i].score += pos->continuation[0][cmPiece][cmTo][piece][to];
+            list->moves[i].score += thread->continuation[0][cmPiece][cmTo][piece][to];
 
         // Add Follow Move History if it exists
         if (follow != NONE_MOVE && follow != NULL_MOVE)
-            list->moves[i].score += pos->continuation[1][fmPiece][fmTo][piece][to];
+            list->moves[i].score += thread->continuation[1][fmPiece][fmTo][piece][to];
 
         // Add Grandchild Move History if it exists
         if (grandchild != NONE_MOVE && grandchild != NULL_MOVE)
-            list->moves[i].score += pos->continuation[1][gcmPiece][gcmTo][piece][to];
+            list->moves[i].score += thread->continuation[1][gcmPiece][gcmTo][piece][to];
 
         // Add Grandchildren Move History if it exists
         if (grandchildren != NONE_MOVE && grandchildren != NULL_MOVE)
-            list->moves[i].score += pos->continuation[1][gchmPiece][gchmTo][piece][to];
+            list->moves[i].score += thread->continuation[1][gchmPiece][gchmTo][piece][to];
     }
 }
 
-void getRefutationMoves(Board *pos, SearchInfo *info, int height, int *killer1, int *killer2, int *counter) {
+void getRefutationMoves(Thread *thread, int height, int *killer1, int *killer2, int *counter) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
 
     // Extract information from one move ago.
     int previous = info->currentMove[height-1];
@@ -218,10 +231,10 @@ void getRefutationMoves(Board *pos, SearchInfo *info, int height, int *killer1,
     int cmTo = SQ64(TOSQ(previous));
 
     // Set Killer Moves by height
-    *killer1 = pos->killers[height][0];
-    *killer2 = pos->killers[height][1];
+    *killer1 = thread->killers[height][0];
+    *killer2 = thread->killers[height][1];
 
     // Set Counter Move if one exists
     if (previous == NONE_MOVE || previous == NULL_MOVE) *counter = NONE_MOVE;
-    else *counter = pos->cmtable[!pos->side][cmPiece][cmTo];
+    else *counter = thread->cmtable[!pos->side][cmPiece][cmTo];
 }
@@ -27,9 +27,9 @@ static const int HistoryMultiplier = 32;
 static const int HistoryDivisor = 512;
 static const int HistoryNMP = 23552;
 
-void updateHistoryStats(Board *pos, SearchInfo *info, int *quiets, int quietsPlayed, int height, int bonus);
-void updateKillerMoves(Board *pos, int height, int move);
+void updateHistoryStats(Thread *thread, int *quiets, int quietsPlayed, int height, int bonus);
+void updateKillerMoves(Thread *thread, int height, int move);
 
-void getHistoryScore(Board *pos, SearchInfo *info, int move, int height, int *hist, int *cmhist, int *fmhist, int *gcmhist, int *gchmhist);
-void scoreQuietMoves(Board *pos, SearchInfo *info, MoveList *list, int start, int length, int height);
-void getRefutationMoves(Board *pos, SearchInfo *info, int height, int *killer1, int *killer2, int *counter);
\ No newline at end of file
+void getHistoryScore(Thread *thread, int move, int height, int *hist, int *cmhist, int *fmhist, int *gcmhist, int *gchmhist);
+void scoreQuietMoves(Thread *thread, MoveList *list, int start, int length, int height);
+void getRefutationMoves(Thread *thread, int height, int *killer1, int *killer2, int *counter);
\ No newline at end of file
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "attack.h"
 #include "bitboards.h"
 #include "board.h"
 #include "data.h"
@@ -106,30 +107,6 @@ void PawnAttacksMasks() {
 	}
 }
 
-void setSquaresNearKing() {
-
-    for (int i = 0; i < 120; ++i) {
-        for (int j = 0; j < 120; ++j) {
-
-            e.sqNearK[i][j] = 0;
-            // e.sqNearK [ KingSq[!side] ] [t_sq] 
-
-            if (!SQOFFBOARD(i) && !SQOFFBOARD(j)) {
-
-            	if (j == i)
-            		e.sqNearK[i][j] = 1;
-
-                /* squares constituting the ring around both kings */
-                if (   j == i + 10 || j == i - 10 
-					|| j == i + 1  || j == i - 1 
-					|| j == i + 9  || j == i - 9 
-					|| j == i + 11 || j == i - 11)
-                	e.sqNearK[i][j] = 1;
-            }
-        }
-    }
-}
-
 void InitEvalMasks() {
 
 	for (int sq = 0; sq < 64; ++sq) {
@@ -147,9 +124,9 @@ void AllInit() {
 	InitFilesRanksBrd();
 	InitEvalMasks();
 	initLMRTable();
-	setSquaresNearKing();
 	KingAreaMask();
 	PawnAttacksMasks();
+	initAttacks();
 	setPcsq32();
-	initTTable(16);
+	initTTable(16, 1);
 }
\ No newline at end of file
@@ -28,6 +28,7 @@
 #include "endgame.h"
 #include "evaluate.h"
 #include "hashkeys.h"
+#include "init.h"
 #include "makemove.h"
 #include "movegen.h"
 #include "validate.h"
@@ -47,12 +48,6 @@ const int CastlePerm[120] = {
     15, 15, 15, 15, 15, 15, 15, 15, 15, 15
 };
 
-static void prefetchMaterialEntry(uint64_t materialKey) {
-
-    Material_Entry *entry = &Table.entry[materialKey >> MT_HASH_SHIFT];
-    __builtin_prefetch(entry);
-}
-
 static void ClearPiece(const int sq, Board *pos) {
 
 	ASSERT(SqOnBoard(sq));
@@ -71,12 +66,16 @@ static void ClearPiece(const int sq, Board *pos) {
     HASH_PCE(pce, sq);
 	
 	pos->pieces[sq] = EMPTY;
+	clearBit(&pos->pieceBB[pce], SQ64(sq));
+	clearBit(&pos->colourBB[col], SQ64(sq));
+	clearBit(&pos->colourBB[COLOUR_NB], SQ64(sq));
 	pos->mPhases[col] -= PieceValPhases[pce];
     pos->material[col] -= PieceValue[EG][pce];
 	
 	if (PieceBig[pce]) {
 		pos->bigPce[col]--;
 	} else {
+		HASH_PAWN(pce, sq);
 		clearBit(&pos->pawns[col], SQ64(sq));
 		clearBit(&pos->pawns[COLOUR_NB], SQ64(sq));
 
@@ -114,10 +113,14 @@ static void AddPiece(const int sq, Board *pos, const int pce) {
     HASH_PCE(pce,sq);
 	
 	pos->pieces[sq] = pce;
+	setBit(&pos->pieceBB[pce], SQ64(sq));
+	setBit(&pos->colourBB[col], SQ64(sq));
+	setBit(&pos->colourBB[COLOUR_NB], SQ64(sq));
 
     if (PieceBig[pce]) {
 		pos->bigPce[col]++;
 	} else {
+		HASH_PAWN(pce, sq);
 		setBit(&pos->pawns[col], SQ64(sq));
 		setBit(&pos->pawns[COLOUR_NB], SQ64(sq));
 
@@ -156,10 +159,18 @@ static void MovePiece(const int from, const int to, Board *pos) {
 	HASH_PCE(pce, to);
 	pos->pieces[to] = pce;
 
+	// Both squares toggle in a single xor for each bitboard
+	uint64_t fromTo = (1ull << SQ64(from)) | (1ull << SQ64(to));
+	pos->pieceBB[pce] ^= fromTo;
+	pos->colourBB[col] ^= fromTo;
+	pos->colourBB[COLOUR_NB] ^= fromTo;
+
     // update piece-square value
     pos->PSQT[col] += e.PSQT[pce][to];
 	
 	if (!PieceBig[pce]) {
+		HASH_PAWN(pce, from);
+		HASH_PAWN(pce, to);
 		clearBit(&pos->pawns[col], SQ64(from));
 		clearBit(&pos->pawns[COLOUR_NB], SQ64(from));
 		setBit(&pos->pawns[col], SQ64(to));
@@ -185,7 +196,7 @@ static void MovePiece(const int from, const int to, Board *pos) {
 	ASSERT(t_PieceNum);
 }
 
-int MakeMove(Board *pos, int move) {
+void MakeMove(Board *pos, int move) {
 
 	ASSERT(CheckBoard(pos));
 	
@@ -200,6 +211,10 @@ int MakeMove(Board *pos, int move) {
 	ASSERT(pos->hisPly >= 0 && pos->hisPly < MAXGAMEMOVES);
 	ASSERT(pos->ply >= 0 && pos->ply < MAX_PLY);
 	
+#if defined(COPYMAKE)
+	pos->history[pos->hisPly].board = *pos;
+#endif
+
 	pos->history[pos->hisPly].posKey = pos->posKey;
 	pos->history[pos->hisPly].materialKey = pos->materialKey;
 	
@@ -247,9 +262,8 @@ int MakeMove(Board *pos, int move) {
 	if (captured != EMPTY) {
         ASSERT(PieceValid(captured));
         ClearPiece(to, pos);
-        // Update material hash key and prefetch access to materialTable
+        // Update material hash key
       	pos->materialKey ^= PieceKeys[captured][pos->pceNum[captured]];
-      	prefetchMaterialEntry(pos->materialKey);
         pos->fiftyMove = 0;
     }
 
@@ -282,11 +296,9 @@ int MakeMove(Board *pos, int move) {
         ASSERT(PieceValid(prPce) && !PiecePawn[prPce]);
         ClearPiece(to, pos);
         AddPiece(to, pos, prPce);
-        // Update material hash key and prefetch access to materialTable
+        // Update material hash key
         pos->materialKey ^=  PieceKeys[prPce][pos->pceNum[prPce]-1]
                            ^ PieceKeys[pos->pieces[to]][pos->pceNum[pos->pieces[to]]];
-        
-        prefetchMaterialEntry(pos->materialKey);
     }
 	
 	if (PieceKing[pos->pieces[to]])
@@ -297,17 +309,23 @@ int MakeMove(Board *pos, int move) {
 
     ASSERT(CheckBoard(pos));
 		
-	if (SqAttacked(pos->KingSq[side],pos->side,pos)) {
-        TakeMove(pos);
-        return 0;
-    }
-	
-	return 1;
+	// Moves come from the legal generator, so our King is never left in check
+	ASSERT(!SqAttacked(pos->KingSq[side],pos->side,pos));
 }
 
 void TakeMove(Board *pos) {
 	
 	ASSERT(CheckBoard(pos));
+
+#if defined(COPYMAKE)
+
+	// MakeMove() kept the whole position from before the move
+	*pos = pos->history[pos->hisPly - 1].board;
+
+	ASSERT(pos->hisPly >= 0 && pos->hisPly < MAXGAMEMOVES);
+	ASSERT(CheckBoard(pos));
+
+#else
 	
 	pos->hisPly--;
 	pos->gamePly--;
@@ -379,6 +397,8 @@ void TakeMove(Board *pos) {
     }
 	
     ASSERT(CheckBoard(pos));
+
+#endif
 }
 
 void MakeNullMove(Board *pos) {
@@ -437,20 +457,7 @@ int LegalMoveExist(Board *pos) {
 	MoveList list = {0};
     GenerateAllMoves(pos, &list);
 
-    int played = 0;
-	for (int MoveNum = 0; MoveNum < list.count; ++MoveNum) {
-
-        if (!MakeMove(pos, list.moves[MoveNum].move))
-            continue;
-
-        played += 1;
-        TakeMove(pos);
-
-	    if (played >= 1)
-	        return 1;
-    }
-
-	return 0;
+	return list.count > 0;
 }
 
 int MoveExists(MoveList *list, const int move) {
@@ -467,12 +474,12 @@ int moveIsQuiet(int move) {
 	return !(move & (MFLAGCAP | MFLAGPROM | MFLAGEP));
 }
 
-int moveBestCaseValue(const Board *pos) {
+static const int SEEPieceValues[13] = {
+	0, 100, 450, 450, 675, 1300, 
+	0, 100, 450, 450, 675, 1300, 0
+};
 
-	static const int SEEPieceValues[13] = {
-    	0, 100, 450, 450, 675, 1300, 
-    	0, 100, 450, 450, 675, 1300, 0
-	};
+int moveBestCaseValue(const Board *pos) {
 
     // Assume the opponent has at least a pawn
     int value = SEEPieceValues[wP];
@@ -500,58 +507,96 @@ int moveBestCaseValue(const Board *pos) {
 
 int see(const Board *pos, int move, int threshold) {
 
-    int from = FROMSQ(move), to = TOSQ(move);
-    int nextVictim = pos->pieces[from];
+    // Static Exchange Evaluation: whether the exchange started by the move
+    // on its target square wins at least the threshold, with both sides
+    // always recapturing with their least valuable piece, and free to
+    // stop whenever recapturing would lose
+
+    int colour, type, piece;
+    uint64_t occupied, attackers, myAttackers;
+
+    const int from = SQ64(FROMSQ(move)), to = SQ64(TOSQ(move));
+    const int promoted = PROMOTED(move);
+
+    // Castling can not lose material
+    if (move & MFLAGCA)
+        return threshold <= 0;
 
-    int balance = PieceValue[EG][pos->pieces[to]] - threshold;
+    // The piece on the square once the move is made, and what it took
+    int nextVictim = promoted ? promoted : pos->pieces[FROMSQ(move)];
+    int balance = (move & MFLAGEP ? SEEPieceValues[wP] : SEEPieceValues[pos->pieces[TOSQ(move)]])
+                + (promoted ? SEEPieceValues[promoted] - SEEPieceValues[wP] : 0)
+                - threshold;
 
+    // Even keeping what was taken for free does not reach the threshold
     if (balance < 0)
         return 0;
 
-    balance -= PieceValue[EG][nextVictim];
-
+    // Losing the moved piece for nothing still reaches the threshold
+    balance -= SEEPieceValues[nextVictim];
     if (balance >= 0)
         return 1;
 
-    return (!pos->side) != pos->side;
-}
+    // Take the moved piece, and an en passant victim, off of the board
+    occupied = (pos->colourBB[COLOUR_NB] ^ (1ull << from)) | (1ull << to);
+    if (move & MFLAGEP)
+        occupied ^= 1ull << (to + (pos->side == WHITE ? -8 : 8));
 
-int badCapture(int move, const Board *pos) {
+    attackers = attackersToSquare(pos, to, occupied) & occupied;
 
-    const int THEM = !pos->side;
+    const uint64_t bishops = pos->pieceBB[wB] | pos->pieceBB[bB] | pos->pieceBB[wQ] | pos->pieceBB[bQ];
+    const uint64_t rooks   = pos->pieceBB[wR] | pos->pieceBB[bR] | pos->pieceBB[wQ] | pos->pieceBB[bQ];
 
-    int from = FROMSQ(move);
-    int to = TOSQ(move);
-    int captured = CAPTURED(move);
+    colour = !pos->side;
 
-    int Knight = pos->side == WHITE ? bN : wN;
-    int Bishop = pos->side == WHITE ? bB : wB;
+    while (1) {
 
-    // Captures by pawn do not lose material
-    if (pos->pieces[from] == wP || pos->pieces[from] == bP) return 0;
+        // The side to recapture gives up when it has no attackers left
+        myAttackers = attackers & pos->colourBB[colour];
+        if (!myAttackers)
+            break;
 
-    // Captures "lower takes higher" (as well as BxN) are good by definition
-    if (PieceValue[EG][captured] >= PieceValue[EG][pos->pieces[from]] - 30) return 0;
+        // Recapture with the least valuable attacker
+        for (type = PAWN; type < KING; type++)
+            if (myAttackers & pos->pieceBB[type + 6 * colour])
+                break;
 
-    if (   pos->pawn_ctrl[THEM][to]
-        && PieceValue[EG][captured] + 200 < PieceValue[EG][pos->pieces[from]])
-        return 1;
+        piece = type + 6 * colour;
 
-    if (PieceValue[EG][captured] + 500 < PieceValue[EG][pos->pieces[from]]) {
-    
-        if (pos->pceNum[Knight])
-            if (KnightAttack(THEM, to, pos)) return 1;
-
-        if (pos->pceNum[Bishop]) {
-            if (BishopAttack(THEM, to, 11, pos)) return 1;
-            if (BishopAttack(THEM, to,  9, pos)) return 1;
-            if (BishopAttack(THEM, to, -9, pos)) return 1;
-            if (BishopAttack(THEM, to,-11, pos)) return 1;
+        occupied ^= 1ull << getlsb(myAttackers & pos->pieceBB[piece]);
+
+        // Removing a piece may uncover sliders lined up behind it
+        if (type == PAWN || type == BISHOP || type == QUEEN)
+            attackers |= bishopAttacks(to, occupied) & bishops;
+
+        if (type == ROOK || type == QUEEN)
+            attackers |= rookAttacks(to, occupied) & rooks;
+
+        attackers &= occupied;
+        colour = !colour;
+
+        // Negamax the balance, and stop once the recapturing
+        // side is ahead even after losing its capturing piece
+        balance = -balance - 1 - SEEPieceValues[piece];
+
+        if (balance >= 0) {
+
+            // A King may not capture onto a square that is still defended
+            if (type == KING && (attackers & pos->colourBB[colour]))
+                colour = !colour;
+
+            break;
         }
     }
 
-    // If a capture is not processed, it cannot be considered bad
-    return 0;
+    // The side to move wins when the other side made the last capture
+    return pos->side != colour;
+}
+
+int badCapture(int move, const Board *pos) {
+
+    // A capture is bad when the exchange it starts loses material
+    return !see(pos, move, 0);
 }
 
 int move_canSimplify(int move, const Board *pos) {
@@ -33,13 +33,7 @@ struct MoveList {
 	int quiets;
 };
 
-struct Undo {
-	uint64_t posKey, materialKey;
-	int move, enPas, castlePerm;
-	int fiftyMove, plyFromNull;
-};
-
-int MakeMove(Board *pos, int move);
+void MakeMove(Board *pos, int move);
 void TakeMove(Board *pos);
 void MakeNullMove(Board *pos);
 void TakeNullMove(Board *pos);
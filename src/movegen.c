@@ -26,23 +26,13 @@
 #include "data.h"
 #include "defs.h"
 #include "evaluate.h"
+#include "init.h"
 #include "makemove.h"
 #include "movegen.h"
 #include "validate.h"
 
 #define MOVE(f, t, ca, pro, fl) ((f) | ((t) << 7) | ((ca) << 14) | ((pro) << 20) | (fl))
 
-static const int LoopSlidePce[8] = {
-	wB, wR, wQ, 0, bB, bR, bQ, 0
-};
-
-static const int LoopNonSlidePce[6] = {
-	wN, wK, 0, bN, bK, 0
-};
-
-static const int LoopSlideIndex[2] = { 0, 4 };
-static const int LoopNonSlideIndex[2] = { 0, 3 };
-
 static void AddQuietMove(int move, MoveList *list) {
 
 	ASSERT(SqOnBoard(FROMSQ(move)));
@@ -134,230 +124,375 @@ static void AddBlackPawnMove(const int from, const int to, MoveList *list ) {
 		AddQuietMove(MOVE(from, to, EMPTY, EMPTY, 0), list);
 }
 
-void GenerateAllMoves(const Board *pos, MoveList *list) {
-	list->count = 0;
-	genNoisyMoves(pos, list);
-	genQuietMoves(pos, list);
+typedef struct LegalInfo {
+	uint64_t checkers, pinned, target;
+	int ksq;
+} LegalInfo;
+
+static void initLegalInfo(const Board *pos, LegalInfo *li) {
+
+	int sq, side = pos->side;
+	uint64_t snipers, between;
+
+	const uint64_t occupied = pos->colourBB[COLOUR_NB];
+	const uint64_t theirs   = pos->colourBB[!side];
+	const uint64_t bishops  = pos->pieceBB[side == WHITE ? bB : wB] | pos->pieceBB[side == WHITE ? bQ : wQ];
+	const uint64_t rooks    = pos->pieceBB[side == WHITE ? bR : wR] | pos->pieceBB[side == WHITE ? bQ : wQ];
+
+	li->ksq = SQ64(pos->KingSq[side]);
+	li->checkers = attackersToSquare(pos, li->ksq, occupied) & theirs;
+	li->pinned = 0ull;
+
+	// Enemy sliders aiming at our King through exactly one of our pieces
+	snipers = (bishopAttacks(li->ksq, theirs) & bishops) | (rookAttacks(li->ksq, theirs) & rooks);
+	while (snipers) {
+		sq = poplsb(&snipers);
+		between = betweenSquares(li->ksq, sq) & occupied;
+		if (onlyOne(between) && (between & pos->colourBB[side]))
+			li->pinned |= between;
+	}
+
+	// Out of check we may move anywhere, in check we must capture or
+	// block the checker, and in double check only the King may move
+	li->target = !li->checkers        ? ~0ull
+	           :  several(li->checkers) ? 0ull
+	           :  li->checkers | betweenSquares(li->ksq, getlsb(li->checkers));
 }
 
-void genNoisyMoves(const Board *pos, MoveList *list) {
+static uint64_t legalTargets(const LegalInfo *li, int sq) {
 
-	ASSERT(CheckBoard(pos));
+	// A pinned piece may only move along the line through our King
+	return testBit(li->pinned, sq) ? li->target & lineThrough(li->ksq, sq) : li->target;
+}
 
-	int pce, side = pos->side;
-	int sq, t_sq, pceNum, index, pceIndex;
+static int kingSquareSafe(const Board *pos, int sq) {
 
-	if (side == WHITE) {
+	// Lift the King from the board so that it no longer blocks
+	// the attacks of the sliders it is trying to step away from
+	uint64_t occupied = pos->colourBB[COLOUR_NB] ^ pos->pieceBB[pos->side == WHITE ? wK : bK];
 
-		for (pceNum = 0; pceNum < pos->pceNum[wP]; ++pceNum) {
-			sq = pos->pList[wP][pceNum];
-			ASSERT(SqOnBoard(sq));
+	return !(attackersToSquare(pos, sq, occupied) & pos->colourBB[!pos->side]);
+}
 
-			if (!SQOFFBOARD(sq + 9) && PieceCol[pos->pieces[sq + 9]] == BLACK)
-				AddWhitePawnCapMove(sq, sq + 9, pos->pieces[sq + 9], list);
-			
-			if (!SQOFFBOARD(sq + 11) && PieceCol[pos->pieces[sq + 11]] == BLACK)
-				AddWhitePawnCapMove(sq, sq + 11, pos->pieces[sq + 11], list);
+static int enPassantLegal(const Board *pos, const LegalInfo *li, int from, int to) {
 
-			if (pos->enPas != NO_SQ) {
-				if (sq + 9 == pos->enPas) 
-					AddEnPassantMove(MOVE(sq, sq + 9, EMPTY, EMPTY, MFLAGEP), list);
-				
-				if(sq + 11 == pos->enPas) 
-					AddEnPassantMove(MOVE(sq, sq + 11, EMPTY, EMPTY, MFLAGEP), list);
-			}
-		}
+	// En passant removes two pieces from a line at once, so just play
+	// it on the occupancy and look for any attacker left on our King
+	int capSq = to - (pos->side == WHITE ? NORTH : SOUTH);
+	uint64_t occupied = (pos->colourBB[COLOUR_NB] ^ (1ull << from) ^ (1ull << capSq)) | (1ull << to);
 
-	} else {
+	return !(attackersToSquare(pos, li->ksq, occupied) & pos->colourBB[!pos->side] & ~(1ull << capSq));
+}
 
-		for (pceNum = 0; pceNum < pos->pceNum[bP]; ++pceNum) {
-			sq = pos->pList[bP][pceNum];
-			ASSERT(SqOnBoard(sq));
+static int castlePathEmpty(const Board *pos, int right) {
 
-			if (!SQOFFBOARD(sq - 9) && PieceCol[pos->pieces[sq - 9]] == WHITE)
-				AddBlackPawnCapMove(sq, sq - 9, pos->pieces[sq - 9], list);
+	// The King and the rook have not moved, and nothing stands between them
+	if (!(pos->castlePerm & right))
+		return 0;
 
-			if (!SQOFFBOARD(sq - 11) && PieceCol[pos->pieces[sq - 11]] == WHITE)
-				AddBlackPawnCapMove(sq, sq - 11, pos->pieces[sq - 11], list);
-			
-			if (pos->enPas != NO_SQ) {
-				if (sq - 9 == pos->enPas)
-					AddEnPassantMove(MOVE(sq, sq - 9, EMPTY, EMPTY, MFLAGEP), list);
-				
-				if (sq - 11 == pos->enPas)
-					AddEnPassantMove(MOVE(sq, sq - 11, EMPTY, EMPTY, MFLAGEP), list);
-			}
-		}
+	switch (right) {
+		case WKCA: return pos->pieces[F1] == EMPTY && pos->pieces[G1] == EMPTY;
+		case WQCA: return pos->pieces[D1] == EMPTY && pos->pieces[C1] == EMPTY && pos->pieces[B1] == EMPTY;
+		case BKCA: return pos->pieces[F8] == EMPTY && pos->pieces[G8] == EMPTY;
+		case BQCA: return pos->pieces[D8] == EMPTY && pos->pieces[C8] == EMPTY && pos->pieces[B8] == EMPTY;
 	}
 
-	/* Loop for slide pieces */
-	pceIndex = LoopSlideIndex[side];
-	pce = LoopSlidePce[pceIndex++];
-	while (pce != 0) {
-		ASSERT(PieceValid(pce));
-
-		for (pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-			sq = pos->pList[pce][pceNum];
-			ASSERT(SqOnBoard(sq));
-
-			for (index = 0; index < NumDir[pce]; ++index) {
-				t_sq = sq + PceDir[pce][index];
-
-				while (!SQOFFBOARD(t_sq)) {
-					if (pos->pieces[t_sq] != EMPTY) {
-						if (PieceCol[pos->pieces[t_sq]] == !side)
-							AddCaptureMove(MOVE(sq, t_sq, pos->pieces[t_sq], EMPTY, 0), list);
-						
-						break;
-					}
-					t_sq += PceDir[pce][index];
-				}
-			}
-		}
+	return 0;
+}
+
+static int castlePathSafe(const Board *pos, int right) {
 
-		pce = LoopSlidePce[pceIndex++];
+	// The King neither passes through nor lands on an attacked square
+	switch (right) {
+		case WKCA: return !SqAttacked(F1, BLACK, pos) && !SqAttacked(G1, BLACK, pos);
+		case WQCA: return !SqAttacked(D1, BLACK, pos) && !SqAttacked(C1, BLACK, pos);
+		case BKCA: return !SqAttacked(F8, WHITE, pos) && !SqAttacked(G8, WHITE, pos);
+		case BQCA: return !SqAttacked(D8, WHITE, pos) && !SqAttacked(C8, WHITE, pos);
 	}
 
-	/* Loop for non slide */
-	pceIndex = LoopNonSlideIndex[side];
-	pce = LoopNonSlidePce[pceIndex++];
+	return 0;
+}
 
-	while (pce != 0) {
-		ASSERT(PieceValid(pce));
+static int canCastle(const Board *pos, int right) {
+	return castlePathEmpty(pos, right) && castlePathSafe(pos, right);
+}
 
-		for (pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-			sq = pos->pList[pce][pceNum];
-			ASSERT(SqOnBoard(sq));
+static int castleRight(const Board *pos, int move) {
 
-			for (index = 0; index < NumDir[pce]; ++index) {
-				t_sq = sq + PceDir[pce][index];
+	// The castling right used by a castle move of the side to move
+	if (pos->side == WHITE)
+		return move == MOVE(E1, G1, EMPTY, EMPTY, MFLAGCA) ? WKCA
+		     : move == MOVE(E1, C1, EMPTY, EMPTY, MFLAGCA) ? WQCA : 0;
 
-				if (SQOFFBOARD(t_sq))
-					continue;
-				
-				if (pos->pieces[t_sq] != EMPTY) {
-					if (PieceCol[pos->pieces[t_sq]] == !side)
-						AddCaptureMove(MOVE(sq, t_sq, pos->pieces[t_sq], EMPTY, 0), list);
-					
+	return move == MOVE(E8, G8, EMPTY, EMPTY, MFLAGCA) ? BKCA
+	     : move == MOVE(E8, C8, EMPTY, EMPTY, MFLAGCA) ? BQCA : 0;
+}
+
+static void genLegalNoisyMoves(const Board *pos, MoveList *list, const LegalInfo *li) {
+
+	ASSERT(CheckBoard(pos));
+
+	int pce, sq, to, side = pos->side;
+	uint64_t pieces, attacks;
+
+	const uint64_t enemy    = pos->colourBB[!side];
+	const uint64_t occupied = pos->colourBB[COLOUR_NB];
+	const uint64_t pawns    = pos->pieceBB[side == WHITE ? wP : bP];
+	const int King          = side == WHITE ? wK : bK;
+
+	/* Pawn captures, including the ones which promote */
+	pieces = pawns;
+	while (pieces) {
+		sq = poplsb(&pieces);
+		attacks = pawnAttacks(side, sq) & enemy & legalTargets(li, sq);
+
+		while (attacks) {
+			to = SQ120(poplsb(&attacks));
+
+			if (side == WHITE)
+				AddWhitePawnCapMove(SQ120(sq), to, pos->pieces[to], list);
+			else
+				AddBlackPawnCapMove(SQ120(sq), to, pos->pieces[to], list);
+		}
+	}
+
+	/* En passant, from the squares a pawn of ours could attack it */
+	if (pos->enPas != NO_SQ) {
+		pieces = pawns & pawnAttacks(!side, SQ64(pos->enPas));
+
+		while (pieces) {
+			sq = poplsb(&pieces);
+			if (enPassantLegal(pos, li, sq, SQ64(pos->enPas)))
+				AddEnPassantMove(MOVE(SQ120(sq), pos->enPas, EMPTY, EMPTY, MFLAGEP), list);
+		}
+	}
+
+	/* Knights, bishops, rooks, queens and the king */
+	for (pce = side == WHITE ? wN : bN; pce <= King; ++pce) {
+
+		pieces = pos->pieceBB[pce];
+		while (pieces) {
+			sq = poplsb(&pieces);
+			attacks = pieceAttacks(pce, sq, occupied) & enemy;
+			attacks &= pce == King ? ~0ull : legalTargets(li, sq);
+
+			while (attacks) {
+				to = poplsb(&attacks);
+
+				if (pce == King && !kingSquareSafe(pos, to))
 					continue;
-				}
+
+				AddCaptureMove(MOVE(SQ120(sq), SQ120(to), pos->pieces[SQ120(to)], EMPTY, 0), list);
 			}
 		}
-
-		pce = LoopNonSlidePce[pceIndex++];
 	}
+
     ASSERT(MoveListOk(list,pos));
 }
 
-void genQuietMoves(const Board *pos, MoveList *list) {
+static void genLegalQuietMoves(const Board *pos, MoveList *list, const LegalInfo *li) {
 
 	ASSERT(CheckBoard(pos));
 
 	list->quiets = 0;
 
-	int pce, side = pos->side;
-	int sq, t_sq, pceNum, index, pceIndex;
+	int pce, sq, to, side = pos->side;
+	uint64_t pieces, attacks, pushes, doubles;
 
-	if (side == WHITE) {
+	const uint64_t empty = ~pos->colourBB[COLOUR_NB];
+	const uint64_t pawns = pos->pieceBB[side == WHITE ? wP : bP];
+	const int up         = side == WHITE ? NORTH : SOUTH;
+	const int King       = side == WHITE ? wK : bK;
 
-		for (pceNum = 0; pceNum < pos->pceNum[wP]; ++pceNum) {
-			sq = pos->pList[wP][pceNum];
-			ASSERT(SqOnBoard(sq));
+	/* Single and double pawn pushes, including the quiet promotions */
+	pushes  = shift(pawns, up) & empty;
+	doubles = shift(pushes & (side == WHITE ? Rank3BB : Rank6BB), up) & empty;
 
-			if (pos->pieces[sq + 10] == EMPTY) {
-				AddWhitePawnMove(sq, sq + 10, list);
-				if (RanksBrd[sq] == RANK_2 && pos->pieces[sq + 20] == EMPTY)
-					AddQuietMove(MOVE(sq, sq + 20, EMPTY, EMPTY, MFLAGPS), list);
-			}
-		}
+	while (pushes) {
+		to = poplsb(&pushes);
 
-		if (pos->castlePerm & WKCA)
-			if (pos->pieces[F1] == EMPTY && pos->pieces[G1] == EMPTY)
-				if (!SqAttacked(E1, BLACK, pos) && !SqAttacked(F1, BLACK, pos))
-					AddQuietMove(MOVE(E1, G1, EMPTY, EMPTY, MFLAGCA), list);
+		if (!testBit(legalTargets(li, to - up), to))
+			continue;
 
-		if (pos->castlePerm & WQCA)
-			if (pos->pieces[D1] == EMPTY && pos->pieces[C1] == EMPTY && pos->pieces[B1] == EMPTY)
-				if (!SqAttacked(E1, BLACK, pos) && !SqAttacked(D1, BLACK, pos))
-					AddQuietMove(MOVE(E1, C1, EMPTY, EMPTY, MFLAGCA), list);
+		if (side == WHITE)
+			AddWhitePawnMove(SQ120(to - up), SQ120(to), list);
+		else
+			AddBlackPawnMove(SQ120(to - up), SQ120(to), list);
+	}
 
-	} else {
+	while (doubles) {
+		to = poplsb(&doubles);
 
-		for (pceNum = 0; pceNum < pos->pceNum[bP]; ++pceNum) {
-			sq = pos->pList[bP][pceNum];
-			ASSERT(SqOnBoard(sq));
+		if (!testBit(legalTargets(li, to - 2 * up), to))
+			continue;
 
-			if (pos->pieces[sq - 10] == EMPTY) {
-				AddBlackPawnMove(sq, sq - 10, list);
-				if (RanksBrd[sq] == RANK_7 && pos->pieces[sq - 20] == EMPTY)
-					AddQuietMove(MOVE(sq, sq - 20, EMPTY, EMPTY, MFLAGPS), list);
-			}
-		}
+		AddQuietMove(MOVE(SQ120(to - 2 * up), SQ120(to), EMPTY, EMPTY, MFLAGPS), list);
+	}
+
+	/* Castling, neither out of, through nor into check */
+	if (side == WHITE && !li->checkers) {
 
-		// castling
-		if (pos->castlePerm &  BKCA)
-			if (pos->pieces[F8] == EMPTY && pos->pieces[G8] == EMPTY)
-				if (!SqAttacked(E8, WHITE, pos) && !SqAttacked(F8, WHITE, pos))
-					AddQuietMove(MOVE(E8, G8, EMPTY, EMPTY, MFLAGCA), list);
+		if (canCastle(pos, WKCA))
+			AddQuietMove(MOVE(E1, G1, EMPTY, EMPTY, MFLAGCA), list);
 
-		if (pos->castlePerm &  BQCA)
-			if (pos->pieces[D8] == EMPTY && pos->pieces[C8] == EMPTY && pos->pieces[B8] == EMPTY)
-				if (!SqAttacked(E8, WHITE, pos) && !SqAttacked(D8, WHITE, pos))
-					AddQuietMove(MOVE(E8, C8, EMPTY, EMPTY, MFLAGCA), list);
+		if (canCastle(pos, WQCA))
+			AddQuietMove(MOVE(E1, C1, EMPTY, EMPTY, MFLAGCA), list);
+
+	} else if (side == BLACK && !li->checkers) {
+
+		if (canCastle(pos, BKCA))
+			AddQuietMove(MOVE(E8, G8, EMPTY, EMPTY, MFLAGCA), list);
+
+		if (canCastle(pos, BQCA))
+			AddQuietMove(MOVE(E8, C8, EMPTY, EMPTY, MFLAGCA), list);
 	}
 
-	/* Loop for slide pieces */
-	pceIndex = LoopSlideIndex[side];
-	pce = LoopSlidePce[pceIndex++];
-	while (pce != 0) {
-		ASSERT(PieceValid(pce));
-
-		for (pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-			sq = pos->pList[pce][pceNum];
-			ASSERT(SqOnBoard(sq));
-
-			for (index = 0; index < NumDir[pce]; ++index) {
-				t_sq = sq + PceDir[pce][index];
-
-				while (!SQOFFBOARD(t_sq)) {
-					if (pos->pieces[t_sq] != EMPTY)
-						break;
-					
-					AddQuietMove(MOVE(sq, t_sq, EMPTY, EMPTY, 0), list);
-					t_sq += PceDir[pce][index];
-				}
+	/* Knights, bishops, rooks, queens and the king */
+	for (pce = side == WHITE ? wN : bN; pce <= King; ++pce) {
+
+		pieces = pos->pieceBB[pce];
+		while (pieces) {
+			sq = poplsb(&pieces);
+			attacks = pieceAttacks(pce, sq, ~empty) & empty;
+			attacks &= pce == King ? ~0ull : legalTargets(li, sq);
+
+			while (attacks) {
+				to = poplsb(&attacks);
+
+				if (pce == King && !kingSquareSafe(pos, to))
+					continue;
+
+				AddQuietMove(MOVE(SQ120(sq), SQ120(to), EMPTY, EMPTY, 0), list);
 			}
 		}
-
-		pce = LoopSlidePce[pceIndex++];
 	}
 
-	/* Loop for non slide */
-	pceIndex = LoopNonSlideIndex[side];
-	pce = LoopNonSlidePce[pceIndex++];
+    ASSERT(MoveListOk(list, pos));
+}
 
-	while (pce != 0) {
-		ASSERT(PieceValid(pce));
+void GenerateAllMoves(const Board *pos, MoveList *list) {
 
-		for (pceNum = 0; pceNum < pos->pceNum[pce]; ++pceNum) {
-			sq = pos->pList[pce][pceNum];
-			ASSERT(SqOnBoard(sq));
+	LegalInfo li;
+	initLegalInfo(pos, &li);
 
-			for (index = 0; index < NumDir[pce]; ++index) {
-				t_sq = sq + PceDir[pce][index];
+	list->count = 0;
+	genLegalNoisyMoves(pos, list, &li);
+	genLegalQuietMoves(pos, list, &li);
+}
 
-				if (SQOFFBOARD(t_sq))
-					continue;
+void genNoisyMoves(const Board *pos, MoveList *list) {
 
-				if (pos->pieces[t_sq] != EMPTY)
-					continue;
-				
-				AddQuietMove(MOVE(sq, t_sq, EMPTY, EMPTY, 0), list);
-			}
+	LegalInfo li;
+	initLegalInfo(pos, &li);
+	genLegalNoisyMoves(pos, list, &li);
+}
+
+void genQuietMoves(const Board *pos, MoveList *list) {
+
+	LegalInfo li;
+	initLegalInfo(pos, &li);
+	genLegalQuietMoves(pos, list, &li);
+}
+
+int moveIsPseudoLegal(const Board *pos, int move) {
+
+	// Validate any 25 bit encoding against the board, the castling rights
+	// and the en passant square, as moves from the Transposition Table or
+	// the refutation tables may come from another position. A move passes
+	// when the generator would produce it, if it ignored pins and checks
+
+	int piece, promo, flag, up, relRank, valid, from64, to64;
+
+	const int from = FROMSQ(move), to = TOSQ(move), side = pos->side;
+
+	if (   move == NONE_MOVE || move == NULL_MOVE
+	    || from >= BRD_SQ_NUM || SQOFFBOARD(from)
+	    || to   >= BRD_SQ_NUM || SQOFFBOARD(to))
+		return 0;
+
+	piece = pos->pieces[from];
+	if (piece == EMPTY || PieceCol[piece] != side)
+		return 0;
+
+	from64 = SQ64(from), to64 = SQ64(to);
+
+	/* Castling carries no other information than its two squares */
+	if (move & MFLAGCA) {
+		int right = castleRight(pos, move);
+		return right && castlePathEmpty(pos, right);
+	}
+
+	/* En passant, to the square behind the pawn which just moved */
+	if (move & MFLAGEP)
+		return  move == MOVE(from, to, EMPTY, EMPTY, MFLAGEP)
+		    &&  PiecePawn[piece]
+		    &&  to == pos->enPas
+		    &&  testBit(pawnAttacks(side, from64), to64);
+
+	// We may never capture our own pieces
+	if (pos->pieces[to] != EMPTY && PieceCol[pos->pieces[to]] == side)
+		return 0;
+
+	if (PiecePawn[piece]) {
+
+		up      = side == WHITE ? NORTH : SOUTH;
+		relRank = side == WHITE ? RanksBrd[from] : RANK_8 - RanksBrd[from];
+		promo   = PROMOTED(move);
+		flag    = to64 == from64 + 2 * up ? MFLAGPS : 0;
+
+		// Pushes land on empty squares, captures on an enemy piece
+		if (to64 == from64 + up)
+			valid = pos->pieces[to] == EMPTY;
+
+		else if (flag == MFLAGPS)
+			valid =  relRank == RANK_2
+			     &&  pos->pieces[to] == EMPTY
+			     &&  pos->pieces[SQ120(from64 + up)] == EMPTY;
+
+		else
+			valid =  testBit(pawnAttacks(side, from64), to64)
+			     &&  pos->pieces[to] != EMPTY;
+
+		if (!valid)
+			return 0;
+
+		// Pawns reaching the last rank must promote, to a piece of ours
+		if (relRank == RANK_7) {
+			if (   promo < (side == WHITE ? wN : bN)
+			    || promo > (side == WHITE ? wQ : bQ))
+				return 0;
 		}
+		else promo = EMPTY;
 
-		pce = LoopNonSlidePce[pceIndex++];
+		// Every other field must be exactly what the generator sets
+		return move == MOVE(from, to, pos->pieces[to], promo, flag);
 	}
 
-    ASSERT(MoveListOk(list, pos));
-}
\ No newline at end of file
+	return  move == MOVE(from, to, pos->pieces[to], EMPTY, 0)
+	    &&  testBit(pieceAttacks(piece, from64, pos->colourBB[COLOUR_NB]), to64);
+}
+
+int moveIsLegal(const Board *pos, int move) {
+
+	// Answer whether the generator would produce the move, without
+	// generating anything: a pseudo legal move must also keep our
+	// King out of check, the same way that every generated move does
+
+	LegalInfo li;
+	int from64, to64;
+
+	if (!moveIsPseudoLegal(pos, move))
+		return 0;
+
+	initLegalInfo(pos, &li);
+	from64 = SQ64(FROMSQ(move)), to64 = SQ64(TOSQ(move));
+
+	if (move & MFLAGCA)
+		return !li.checkers && castlePathSafe(pos, castleRight(pos, move));
+
+	if (move & MFLAGEP)
+		return enPassantLegal(pos, &li, from64, to64);
+
+	return PieceKing[pos->pieces[FROMSQ(move)]] ? kingSquareSafe(pos, to64)
+	                                            : testBit(legalTargets(&li, from64), to64);
+}
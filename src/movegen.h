@@ -23,4 +23,6 @@
 void GenerateAllMoves(const Board *pos, MoveList *list);
 void genNoisyMoves(const Board *pos, MoveList *list);
 void genQuietMoves(const Board *pos, MoveList *list);
+int moveIsPseudoLegal(const Board *pos, int move);
+int moveIsLegal(const Board *pos, int move);
 void InitMvvLva();
\ No newline at end of file
@@ -72,30 +72,30 @@ static void scoreNoisyMoves(MoveList *list, Board *pos, int noisySize) {
     }
 }
 
-void initMovePicker(MovePicker *mp, Board *pos, SearchInfo *info, MoveList *list, int ttMove, int height) {
+void initMovePicker(MovePicker *mp, Thread *thread, MoveList *list, int ttMove, int height) {
 
-    // Start with the ttMove, but first generate moves
-    // to probe if ttMove is pseudo legal.
-    mp->stage = GENERATE_MOVES;
+    // Start with the ttMove, which is validated on its own,
+    // so that nothing is generated when it causes a cutoff
+    mp->stage = TTABLE;
     mp->ttMove = ttMove;
 
     // Lookup our refutations (killers and counter moves)
-    getRefutationMoves(pos, info, height, &mp->killer1, &mp->killer2, &mp->counter);
+    getRefutationMoves(thread, height, &mp->killer1, &mp->killer2, &mp->counter);
 
-    mp->info = info;
+    mp->thread = thread;
     mp->list = list;
     mp->height = height;
     mp->type = NORMAL_PICKER;
 }
 
-void initNoisyMovePicker(MovePicker *mp, SearchInfo *info, MoveList *list) {
+void initNoisyMovePicker(MovePicker *mp, Thread *thread, MoveList *list) {
 
     // Start generating noisy moves
-    mp->stage = GENERATE_MOVES;
+    mp->stage = SCORE_NOISY;
 
     // Skip all of the special (refutation and table) moves
     mp->ttMove = mp->killer1 = mp->killer2 = mp->counter = NONE_MOVE;
-    mp->info = info;
+    mp->thread = thread;
     mp->list = list;
     mp->height = 0;
     mp->type = NOISY_PICKER;
@@ -107,33 +107,22 @@ int selectNextMove(MovePicker *mp, Board *pos, int skipQuiets) {
 
     switch (mp->stage) {
 
-        case GENERATE_MOVES:
-
-            // Generate the moves to be played.
-            mp->stage = TTABLE;
-            if (mp->type == NORMAL_PICKER)
-                GenerateAllMoves(pos, mp->list);
-
-            // Skip ttMove here.
-            if (mp->type == NOISY_PICKER)
-                genNoisyMoves(pos, mp->list), mp->stage = SCORE_NOISY;
-
-            /* fallthrough */
-
         case TTABLE:
 
-            // Play ttMove if it is pseudo legal
+            // Play ttMove if it is legal
             mp->stage = SCORE_NOISY;
-            if (MoveExists(mp->list, mp->ttMove))
+            if (moveIsLegal(pos, mp->ttMove))
                 return mp->ttMove;
 
             /* fallthrough */
 
         case SCORE_NOISY:
 
-            // Score noisy moves, also set mp->split as a break point
-            // to seperate the noisy from the quiet moves.
-            mp->noisySize = mp->split = mp->list->count - mp->list->quiets;
+            // Generate and score noisy moves, also set mp->split as a break
+            // point to seperate the noisy from the quiets generated later
+            mp->list->count = 0;
+            genNoisyMoves(pos, mp->list);
+            mp->noisySize = mp->split = mp->list->count;
             scoreNoisyMoves(mp->list, pos, mp->noisySize);
             mp->stage = NOISY;
 
@@ -174,47 +163,48 @@ int selectNextMove(MovePicker *mp, Board *pos, int skipQuiets) {
 
         case KILLER_1:
 
-            // Play killer move if not yet played, and pseudo legal
+            // Play killer move if not yet played, and legal
             mp->stage = KILLER_2;
             if (   !skipQuiets
                 &&  mp->killer1 != mp->ttMove
-                &&  MoveExists(mp->list, mp->killer1))
+                &&  moveIsLegal(pos, mp->killer1))
                 return mp->killer1;
 
             /* fallthrough */
 
         case KILLER_2:
 
-            // Play killer move if not yet played, and pseudo legal
+            // Play killer move if not yet played, and legal
             mp->stage = COUNTER_MOVE;
             if (   !skipQuiets
                 &&  mp->killer2 != mp->ttMove
-                &&  MoveExists(mp->list, mp->killer2))
+                &&  moveIsLegal(pos, mp->killer2))
                 return mp->killer2;
 
             /* fallthrough */
 
         case COUNTER_MOVE:
 
-            // Play counter move if not yet played, and pseudo legal
+            // Play counter move if not yet played, and legal
             mp->stage = SCORE_QUIET;
             if (   !skipQuiets
                 &&  mp->counter != mp->ttMove
                 &&  mp->counter != mp->killer1
                 &&  mp->counter != mp->killer2
-                &&  MoveExists(mp->list, mp->counter))
+                &&  moveIsLegal(pos, mp->counter))
                 return mp->counter;
 
             /* fallthrough */
 
         case SCORE_QUIET:
 
-            // Score quiet moves when not skipping them
+            // Generate and score quiet moves when not skipping them
             mp->stage = QUIET;
             if (!skipQuiets) {
 
-                mp->quietSize = mp->list->quiets;        
-                scoreQuietMoves(pos, mp->info, mp->list, mp->split, mp->quietSize, mp->height);
+                genQuietMoves(pos, mp->list);
+                mp->quietSize = mp->list->quiets;
+                scoreQuietMoves(mp->thread, mp->list, mp->split, mp->quietSize, mp->height);
 
                 ASSERT(MoveListOk(mp->list, pos));
             }
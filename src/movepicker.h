@@ -25,7 +25,7 @@
 enum { NORMAL_PICKER, NOISY_PICKER };
 
 enum {
-    GENERATE_MOVES, TTABLE,
+    TTABLE,
     SCORE_NOISY, NOISY,
     KILLER_1, KILLER_2, COUNTER_MOVE,
     SCORE_QUIET, QUIET, DONE,
@@ -36,9 +36,9 @@ struct MovePicker {
     int stage, height, type;
     int ttMove, killer1, killer2, counter;
     MoveList *list;
-    SearchInfo *info;
+    Thread *thread;
 };
 
-void initMovePicker(MovePicker *mp, Board *pos, SearchInfo *info, MoveList *list, int ttMove, int height);
-void initNoisyMovePicker(MovePicker *mp, SearchInfo *info, MoveList *list);
+void initMovePicker(MovePicker *mp, Thread *thread, MoveList *list, int ttMove, int height);
+void initNoisyMovePicker(MovePicker *mp, Thread *thread, MoveList *list);
 int selectNextMove(MovePicker *mp, Board *pos, int skipQuiets);
@@ -0,0 +1,83 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ * 
+ *  Copyright (C) 2019 Roberto Martinez
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// pawns.c
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "defs.h"
+#include "evaluate.h"
+#include "pawns.h"
+
+void initPawnTable(Pawn_Table *pawnTable, uint64_t MB) {
+
+    uint64_t entries = 1ull;
+
+    // Use the largest power of two number of entries fitting in
+    // the given size, so that the key can be masked into an index
+    MB = MAX(1ull, MIN(MB, (uint64_t)PAWN_HASH_MAX));
+    while (entries * 2 * sizeof(Pawn_Entry) <= MB << 20)
+        entries *= 2;
+
+    freePawnTable(pawnTable);
+
+    pawnTable->entry = calloc(entries, sizeof(Pawn_Entry));
+    pawnTable->hashMask = entries - 1;
+    pawnTable->probes = pawnTable->hits = 0ull;
+}
+
+void freePawnTable(Pawn_Table *pawnTable) {
+
+    free(pawnTable->entry);
+    pawnTable->entry = NULL;
+    pawnTable->hashMask = 0ull;
+}
+
+void prefetchPawnTable(Pawn_Table *pawnTable, uint64_t key) {
+
+    Pawn_Entry *entry = &pawnTable->entry[key & pawnTable->hashMask];
+    __builtin_prefetch(entry);
+}
+
+Pawn_Entry* Pawn_probe(const Board *pos, Pawn_Table *pawnTable) {
+
+    uint64_t key = pos->pawnKey;
+    Pawn_Entry *entry = &pawnTable->entry[key & pawnTable->hashMask];
+
+    pawnTable->probes++;
+
+    // The tuner needs every pawn term to be traced, so we only make
+    // use of the cached entries during regular evaluations. A cleared
+    // entry is a valid one for the pawnless key, its shelter is unset
+    if (!TRACE && entry->key == key) {
+        pawnTable->hits++;
+        return entry;
+    }
+
+    memset(entry, 0, sizeof(Pawn_Entry));
+
+    entry->key = key;
+    entry->kingSq[WHITE] = entry->kingSq[BLACK] = NO_SQ;
+
+    evaluatePawns(entry, pos);
+
+    return entry;
+}
@@ -0,0 +1,50 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ * 
+ *  Copyright (C) 2019 Roberto Martinez
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "defs.h"
+
+enum {
+    PAWN_HASH_MB  = 2,
+    PAWN_HASH_MAX = 1024,
+};
+
+struct Pawn_Entry {
+    uint64_t key;
+    uint64_t passed;             // Passed pawns of both colours
+    uint64_t attacks[COLOUR_NB]; // Squares attacked by at least one pawn
+    uint64_t attacks2[COLOUR_NB];// Squares attacked by two pawns
+    int eval;                    // King independent pawn structure score
+    int kingSq[COLOUR_NB];       // King square and castling rights that
+    int castling[COLOUR_NB];     // were used to compute the cached shelter
+    int shelter[COLOUR_NB];
+};
+
+struct Pawn_Table {
+    Pawn_Entry *entry;
+    uint64_t hashMask;
+    uint64_t probes, hits;
+};
+
+void initPawnTable(Pawn_Table *pawnTable, uint64_t MB);
+void freePawnTable(Pawn_Table *pawnTable);
+void prefetchPawnTable(Pawn_Table *pawnTable, uint64_t key);
+Pawn_Entry* Pawn_probe(const Board *pos, Pawn_Table *pawnTable);
@@ -0,0 +1,289 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ * 
+ *  Copyright (C) 2019 Roberto Martinez
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// perft.c
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "defs.h"
+#include "io.h"
+#include "makemove.h"
+#include "movegen.h"
+#include "perft.h"
+#include "time.h"
+#include "ttable.h"
+
+enum { PERFT_BUCKET_NB = 4 };
+
+typedef struct PerftEntry {
+    uint64_t key;  // Position key, XOR'ed with the data
+    uint64_t data; // Leaf count (56 bits) and remaining depth (8 bits)
+} PerftEntry;
+
+typedef struct PerftTable {
+    PerftEntry (*buckets)[PERFT_BUCKET_NB];
+    uint64_t hashMask;
+} PerftTable;
+
+typedef struct PerftWorker {
+    Board pos;
+    Undo history[MAXGAMEMOVES];
+    MoveList *list;
+    uint64_t *counts;
+    int *next, depth;
+} PerftWorker;
+
+static PerftTable PT; // Only allocated when perft is asked to use hashing
+
+static void initPerftTable(uint64_t MB) {
+
+    // A power of two of buckets, each filling one 64 byte cache line
+    uint64_t buckets = 1ull;
+
+    for (; buckets * 2 * sizeof(*PT.buckets) <= MB << 20; buckets *= 2);
+
+    PT.hashMask = buckets - 1;
+    PT.buckets = allocHugePages(buckets * sizeof(*PT.buckets));
+    memset(PT.buckets, 0, buckets * sizeof(*PT.buckets));
+}
+
+static void freePerftTable() {
+
+    free(PT.buckets);
+    PT.buckets = NULL, PT.hashMask = 0ull;
+}
+
+static int probePerftTable(uint64_t key, int depth, uint64_t *nodes) {
+
+    PerftEntry *entry = PT.buckets[key & PT.hashMask];
+
+    // The table is shared without locks by all perft threads, so as
+    // with the main TT the key is stored XOR'ed with the data, and a
+    // torn entry will simply fail to match. Counts are only valid
+    // for the exact remaining depth they were computed with
+    for (int i = 0; i < PERFT_BUCKET_NB; i++) {
+
+        uint64_t data = __atomic_load_n(&entry[i].data, __ATOMIC_RELAXED);
+        uint64_t word = __atomic_load_n(&entry[i].key, __ATOMIC_RELAXED) ^ data;
+
+        if (word == key && (int)(data & 0xFF) == depth) {
+            *nodes = data >> 8;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void storePerftTable(uint64_t key, int depth, uint64_t nodes) {
+
+    PerftEntry *entry = PT.buckets[key & PT.hashMask];
+
+    // Replace the shallowest count of the bucket, as deeper
+    // counts are the ones which save the most work on a hit
+    uint64_t data = (nodes << 8) | (uint64_t)depth;
+    int i, replace = 0, depths[PERFT_BUCKET_NB];
+
+    for (i = 0; i < PERFT_BUCKET_NB; i++)
+        depths[i] = __atomic_load_n(&entry[i].data, __ATOMIC_RELAXED) & 0xFF;
+
+    for (i = 1; i < PERFT_BUCKET_NB; i++)
+        if (depths[i] < depths[replace])
+            replace = i;
+
+    __atomic_store_n(&entry[replace].data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry[replace].key, key ^ data, __ATOMIC_RELAXED);
+}
+
+uint64_t perft(Board *pos, int depth) {
+
+    if (depth == 0)
+        return 1ull;
+
+    uint64_t nodes = 0ull;
+
+    // Transpositions are very common this deep in the tree, and the
+    // count below a position only depends on the position and depth
+    if (PT.buckets != NULL && depth >= 2 && probePerftTable(pos->posKey, depth, &nodes))
+        return nodes;
+
+    MoveList list = {0};
+    GenerateAllMoves(pos, &list);
+
+    // Every generated move is legal, so the last ply is just counted
+    if (depth == 1)
+        return list.count;
+
+    for (int i = 0; i < list.count; i++) {
+        MakeMove(pos, list.moves[i].move);
+        nodes += perft(pos, depth - 1);
+        TakeMove(pos);
+    }
+
+    if (PT.buckets != NULL)
+        storePerftTable(pos->posKey, depth, nodes);
+
+    return nodes;
+}
+
+static void* perftWorkerLoop(void *vworker) {
+
+    PerftWorker *worker = (PerftWorker*) vworker;
+    int index;
+
+    // Keep claiming the next root move until all of them are counted.
+    // Subtrees differ wildly in size, so this balances far better
+    // than handing every thread a fixed slice of the root moves
+    while ((index = __atomic_fetch_add(worker->next, 1, __ATOMIC_RELAXED)) < worker->list->count) {
+        MakeMove(&worker->pos, worker->list->moves[index].move);
+        worker->counts[index] = perft(&worker->pos, worker->depth - 1);
+        TakeMove(&worker->pos);
+    }
+
+    return NULL;
+}
+
+uint64_t perftRootMoves(Board *pos, int depth, int nthreads, MoveList *list, uint64_t *counts) {
+
+    // Count the leaves below every root move, splitting the root
+    // moves over the threads. Each Thread works on its own copy
+    // of the position, so no other state is shared between them
+
+    uint64_t nodes = 0ull;
+    int next = 0;
+
+    ASSERT(depth >= 1);
+
+    list->count = 0;
+    GenerateAllMoves(pos, list);
+
+    nthreads = MAX(1, MIN(nthreads, list->count));
+
+    pthread_t pthreads[nthreads];
+    PerftWorker *workers = malloc(nthreads * sizeof(PerftWorker));
+
+    for (int i = 0; i < nthreads; i++) {
+        cloneBoard(&workers[i].pos, workers[i].history, pos);
+        workers[i].list = list, workers[i].counts = counts;
+        workers[i].next = &next, workers[i].depth = depth;
+        pthread_create(&pthreads[i], NULL, &perftWorkerLoop, &workers[i]);
+    }
+
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(pthreads[i], NULL);
+
+    free(workers);
+
+    for (int i = 0; i < list->count; i++)
+        nodes += counts[i];
+
+    return nodes;
+}
+
+void perftDivide(Board *pos, int depth, int nthreads) {
+
+    MoveList list = {0};
+    uint64_t counts[MAX_MOVES], nodes;
+    double start = getTimeMs(), elapsed;
+
+    nodes = perftRootMoves(pos, MAX(1, depth), nthreads, &list, counts);
+    elapsed = getTimeMs() - start;
+
+    for (int i = 0; i < list.count; i++)
+        printf("%s: %"PRIu64"\n", PrMove(list.moves[i].move), counts[i]);
+
+    printf("\nNodes searched: %"PRIu64"\n", nodes);
+    printf("Time %dms NPS %"PRIu64"\n", (int)elapsed, (uint64_t)(1000.0 * nodes / (elapsed + 1)));
+    fflush(stdout);
+}
+
+int runPerftSuite(int argc, char **argv) {
+
+    // Run every position of an EPD suite, up to the given depth, and
+    // compare each count against the ";D<depth> <nodes>" expectations
+
+    Board pos = {0};
+    MoveList list = {0};
+    uint64_t counts[MAX_MOVES], nodes, expected, totalNodes = 0ull;
+    char line[1024], *ptr;
+    int positions = 0, mismatches = 0, d;
+    double start = getTimeMs(), elapsed, time;
+
+    int depth     = argc > 2 ? atoi(argv[2]) : 5;
+    int nthreads  = argc > 3 ? MAX(1, atoi(argv[3])) : 1;
+    int megabytes = argc > 4 ? atoi(argv[4]) : 0;
+    char *suite   = argc > 5 ? argv[5] : "../perftsuite.epd";
+
+    FILE *file = fopen(suite, "r");
+
+    if (file == NULL) {
+        printf("Unable to open %s\n", suite);
+        return 1;
+    }
+
+    if (megabytes > 0)
+        initPerftTable(megabytes);
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+
+        if ((ptr = strchr(line, ';')) == NULL)
+            continue;
+
+        ParseFen(line, &pos);
+        positions++;
+        nodes = 0ull;
+        time = getTimeMs();
+
+        for (; (ptr = strstr(ptr, ";D")) != NULL; ptr++) {
+
+            if (sscanf(ptr, ";D%d %"SCNu64, &d, &expected) != 2 || d < 1 || d > depth)
+                continue;
+
+            uint64_t result = perftRootMoves(&pos, d, nthreads, &list, counts);
+            nodes += result;
+
+            if (result != expected) {
+                mismatches++;
+                printf("Perft [# %3d] D%d %"PRIu64" nodes, expected %"PRIu64"\n",
+                    positions, d, result, expected);
+            }
+        }
+
+        time = getTimeMs() - time;
+        totalNodes += nodes;
+
+        printf("Perft [# %3d] %15"PRIu64" nodes %10d nps\n",
+            positions, nodes, (int)(1000.0 * nodes / (time + 1)));
+    }
+
+    fclose(file);
+    freePerftTable();
+    elapsed = getTimeMs() - start;
+
+    printf("=================================================================================\n");
+    printf("OVERALL: %d positions %"PRIu64" nodes %"PRIu64" nps %d mismatches %dms\n",
+        positions, totalNodes, (uint64_t)(1000.0 * totalNodes / (elapsed + 1)), mismatches, (int)elapsed);
+
+    return mismatches;
+}
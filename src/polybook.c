@@ -16,11 +16,26 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "board.h"
 #include "defs.h"
 #include "io.h"
 #include "polybook.h"
 #include "polykeys.h"
+#include "time.h"
 #include "uci.h"
 
 typedef struct {
@@ -31,49 +46,125 @@ typedef struct {
 	
 } S_POLY_BOOK_ENTRY;
 
+// The book is mapped read-only and never copied, so the page cache holds a
+// single copy of it however many engine processes use the same file, and
+// only the pages touched by the binary search are ever read from the disk
+
 long NumEntries = 0;
 
-S_POLY_BOOK_ENTRY *entries;
+const S_POLY_BOOK_ENTRY *entries;
+
+// With a learning file set, the book in use is that local copy, and the
+// entries played by us in the current game are scored when the game ends.
+// The learn field keeps the games played in its high 16 bits, and the
+// half points we scored with the move in its low 16 bits
+
+enum { MAXBOOKMOVES = 64, MAXBOOKPLAYED = 128 };
+
+static char LearnPath[1024];
+static long BookPlayed[MAXBOOKPLAYED];
+static int BookPlayedCount, LastSearchValue = VALUE_NONE;
+
+static uint64_t BookSeed;
+
+#if defined(_WIN32) || defined(_WIN64)
+static HANDLE BookMapping;
+#else
+static size_t BookSize;
+#endif
 
 const int PolyKindOfPiece[13] = {
 	-1, 1, 3, 5, 7, 9, 11, 0, 2, 4, 6, 8, 10
 };
 
-void InitPolyBook() {
-	
-	if (Options.PolyBook) {
-
-		FILE *pFile = fopen("../book.bin","rb");
-
-		if (pFile == NULL) { 
-			printf("info string Could not open ../book.bin\n");
-			Options.PolyBook = 0; return;
-		} else {
-
-			fseek(pFile,0,SEEK_END);
-			long position = ftell(pFile);
-			
-			if ((unsigned int)(position) < sizeof(S_POLY_BOOK_ENTRY)) {
-				printf("No Entries Found\n");
-				Options.PolyBook = 0; return;
-			}
-			
-			NumEntries = position / sizeof(S_POLY_BOOK_ENTRY);
-			printf("%ld Entries Found In File\n", NumEntries);
-			
-			entries = (S_POLY_BOOK_ENTRY*)malloc(NumEntries * sizeof(S_POLY_BOOK_ENTRY));
-			rewind(pFile);
-			fread(entries, sizeof(S_POLY_BOOK_ENTRY), NumEntries, pFile);
-			
-			printf("info string Book loaded: ../book.bin\n");
-
-			CleanPolyBook();
-		}
+void InitPolyBook(const char *path) {
+
+	size_t size;
+
+	CleanPolyBook();
+
+#if defined(_WIN32) || defined(_WIN64)
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		printf("info string Could not open %s\n", path);
+		return;
+	}
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	size = (size_t)fileSize.QuadPart;
+
+	if (size < sizeof(S_POLY_BOOK_ENTRY)) {
+		printf("info string No entries found in %s\n", path);
+		CloseHandle(file); return;
+	}
+
+	BookMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+
+	if (BookMapping == NULL || !(entries = MapViewOfFile(BookMapping, FILE_MAP_READ, 0, 0, 0))) {
+		printf("info string Could not map %s\n", path);
+		if (BookMapping) CloseHandle(BookMapping);
+		BookMapping = NULL; entries = NULL; return;
+	}
+
+#else
+
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if (fd == -1) {
+		printf("info string Could not open %s\n", path);
+		return;
 	}
+
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(S_POLY_BOOK_ENTRY)) {
+		printf("info string No entries found in %s\n", path);
+		close(fd); return;
+	}
+
+	size = (size_t)st.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // The mapping keeps its own reference to the file
+
+	if (mapping == MAP_FAILED) {
+		printf("info string Could not map %s\n", path);
+		return;
+	}
+
+	// Probes jump around the whole file, so read-ahead would be wasted
+	madvise(mapping, size, MADV_RANDOM);
+	entries = mapping, BookSize = size;
+
+#endif
+
+	NumEntries = size / sizeof(S_POLY_BOOK_ENTRY);
+	printf("info string Book loaded: %s (%ld entries)\n", path, NumEntries);
 }
 
 void CleanPolyBook() {
-	free(entries);
+
+	if (entries == NULL)
+		return;
+
+#if defined(_WIN32) || defined(_WIN64)
+	UnmapViewOfFile(entries);
+	CloseHandle(BookMapping);
+	BookMapping = NULL;
+#else
+	munmap((void *)entries, BookSize);
+	BookSize = 0;
+#endif
+
+	entries = NULL, NumEntries = 0;
+	LearnPath[0] = '\0', BookPlayedCount = 0;
+}
+
+int PolyBookLoaded() {
+	return entries != NULL;
 }
 
 int HasPawnForCapture(const Board *board) {
@@ -194,32 +285,178 @@ int ConvertPolyMoveToInternalMove(uint16_t polyMove, Board *board) {
 	return ParseMove(moveString, board);
 }
 
+static long FirstEntryWithKey(uint64_t polyKey) {
+
+	// Polyglot books are sorted by their big-endian keys, so the first entry
+	// for a position is found by a binary search over the mapped entries
+	long lo = 0, hi = NumEntries;
+
+	while (lo < hi) {
+		long mid = lo + (hi - lo) / 2;
+		if (endian_swap_u64(entries[mid].key) < polyKey)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static uint64_t BookRandom() {
+
+	// Seeded from the clock and the stack address, so that engines
+	// started together on a tournament farm still vary their openings
+	if (!BookSeed) {
+		int local;
+		BookSeed = (uint64_t)getTimeMs() ^ (uint64_t)(uintptr_t)&local;
+	}
+
+	// Splitmix64
+	uint64_t z = (BookSeed += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static double LearnedWeight(const S_POLY_BOOK_ENTRY *entry) {
+
+	// Scale the weight by our score with the move, from about zero
+	// after only losses to about twice the weight after only wins
+	uint32_t learn = endian_swap_u32(entry->learn);
+	double games = learn >> 16, halfPoints = learn & 0xFFFF;
+
+	return endian_swap_u16(entry->weight) * (halfPoints + 1) / (games + 1);
+}
+
 int GetBookMove(Board *board) {
 
-	const int MAXBOOKMOVES = 64;
-	S_POLY_BOOK_ENTRY *entry;
-	uint16_t move;
+	const S_POLY_BOOK_ENTRY *entry;
+	long bookEntries[MAXBOOKMOVES];
+	double weights[MAXBOOKMOVES], total = 0.0;
 	int bookMoves[MAXBOOKMOVES];
-	int tempMove, count = 0;
+	int move, count = 0, best = 0;
+
+	if (entries == NULL || board->gamePly >= Options.BookDepth)
+		return NONE_MOVE;
 
 	uint64_t polyKey = PolyKeyFromBoard(board);
-	
-	for (entry = entries; entry < entries + NumEntries; ++entry) {
-		if (polyKey == endian_swap_u64(entry->key)) {
-			move = endian_swap_u16(entry->move);
-			tempMove = ConvertPolyMoveToInternalMove(move, board);
-			if (tempMove != NONE_MOVE) {
-				bookMoves[count++] = tempMove;
-				if (count > MAXBOOKMOVES) break;
-			}
+
+	// Collect the legal moves of the position which are not below the
+	// minimum weight, along with the weights adjusted by the learning
+	for (entry = entries + FirstEntryWithKey(polyKey);
+		entry < entries + NumEntries && endian_swap_u64(entry->key) == polyKey
+		&& count < MAXBOOKMOVES; ++entry) {
+
+		if (endian_swap_u16(entry->weight) < Options.BookMinWeight)
+			continue;
+
+		move = ConvertPolyMoveToInternalMove(endian_swap_u16(entry->move), board);
+		if (move == NONE_MOVE)
+			continue;
+
+		bookEntries[count] = entry - entries;
+		bookMoves[count] = move;
+		weights[count] = LearnedWeight(entry);
+		total += weights[count];
+
+		if (weights[count] > weights[best])
+			best = count;
+		count++;
+	}
+
+	if (count == 0)
+		return NONE_MOVE;
+
+	// Pick a move with a probability proportional to its weight, unless we
+	// always want the heaviest one. Books without weights play the first
+	if (!Options.BookBestMove && total > 0.0) {
+		double pick = total * (BookRandom() >> 11) / 9007199254740992.0;
+		for (best = 0; best < count - 1 && (pick -= weights[best]) >= 0.0; best++);
+	}
+
+	if (BookPlayedCount < MAXBOOKPLAYED)
+		BookPlayed[BookPlayedCount++] = bookEntries[best];
+
+	return bookMoves[best];
+}
+
+void SetBookLearnFile(const char *path) {
+
+	FILE *fout;
+	int copied;
+
+	// The first time, the learning file starts as a copy of the book
+	if ((fout = fopen(path, "rb")) == NULL) {
+
+		if (entries == NULL || (fout = fopen(path, "wb")) == NULL) {
+			printf("info string Could not create %s from the book\n", path);
+			return;
+		}
+
+		// A partial copy would be mapped as a shorter book, so it is
+		// removed and the original book stays in use
+		copied = (long)fwrite(entries, sizeof(S_POLY_BOOK_ENTRY), NumEntries, fout) == NumEntries;
+		if (fclose(fout) != 0 || !copied) {
+			printf("info string Could not copy the book to %s\n", path);
+			remove(path);
+			return;
 		}
 	}
-	
-	if (count != 0) {
-		for (int index = 0; index < count; ++index) {
-			//printf("BookMove:%d : %s\n", index+1, PrMove(bookMoves[index]));
-			return bookMoves[index];
+
+	else
+		fclose(fout);
+
+	InitPolyBook(path);
+
+	if (entries != NULL)
+		snprintf(LearnPath, sizeof(LearnPath), "%s", path);
+}
+
+void ClearBookLearnFile() {
+
+	// Keep what this game has taught so far, then stop learning. The
+	// learning copy stays loaded as the book until BookFile is set again
+	WriteBookLearn();
+	LearnPath[0] = '\0';
+}
+
+void RecordBookSearch(int value) {
+	LastSearchValue = value;
+}
+
+void WriteBookLearn() {
+
+	FILE *fout;
+	uint32_t learn;
+
+	// The interface never tells us the result, so it is guessed from the
+	// score of our last search, which is 0 when it ended by a draw claim
+	const int halfPoints = LastSearchValue == VALUE_NONE ? -1
+	                     : LastSearchValue >=  BookLearnMargin ? 2
+	                     : LastSearchValue <= -BookLearnMargin ? 0 : 1;
+
+	if (LearnPath[0] && BookPlayedCount && halfPoints >= 0
+		&& (fout = fopen(LearnPath, "r+b")) != NULL) {
+
+		for (int i = 0; i < BookPlayedCount; i++) {
+
+			learn = endian_swap_u32(entries[BookPlayed[i]].learn);
+
+			// Halve both counts before either of them would overflow. A
+			// win adds two half points, so the points fill up first
+			if ((learn >> 16) == 0xFFFF || (learn & 0xFFFF) > 0xFFFF - 2)
+				learn = ((learn >> 17) << 16) | ((learn & 0xFFFF) >> 1);
+
+			learn += (1 << 16) + halfPoints;
+			learn = endian_swap_u32(learn);
+
+			fseek(fout, BookPlayed[i] * (long)sizeof(S_POLY_BOOK_ENTRY)
+				+ (long)offsetof(S_POLY_BOOK_ENTRY, learn), SEEK_SET);
+			fwrite(&learn, sizeof(learn), 1, fout);
 		}
-	} 
-	return NONE_MOVE;
-}
\ No newline at end of file
+
+		fclose(fout);
+	}
+
+	BookPlayedCount = 0, LastSearchValue = VALUE_NONE;
+}
@@ -18,6 +18,16 @@
 
 #pragma once
 
+enum { MAX_BOOK_DEPTH = 255 };
+
+// Scores beyond this margin guess a won or lost game for the learning
+static const int BookLearnMargin = 300;
+
 int GetBookMove(Board *board);
+int PolyBookLoaded();
 void CleanPolyBook();
-void InitPolyBook();
\ No newline at end of file
+void InitPolyBook(const char *path);
+void SetBookLearnFile(const char *path);
+void ClearBookLearnFile();
+void RecordBookSearch(int value);
+void WriteBookLearn();
\ No newline at end of file
@@ -21,9 +21,11 @@
 
 #include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "attack.h"
 #include "bitboards.h"
@@ -35,34 +37,131 @@
 #include "makemove.h"
 #include "movepicker.h"
 #include "movegen.h"
+#include "pawns.h"
 #include "polybook.h"
 #include "search.h"
+#include "syzygy.h"
+#include "thread.h"
 #include "time.h"
 #include "ttable.h"
 #include "uci.h"
 
 int LMRTable[64][64]; // Late Move Reductions Table
 
+static int ponderMoveFromTT(Board *pos, int best) {
+
+    int ttMove, ttValue, ttEval, ttDepth, ttBound, ponder = NONE_MOVE;
+
+    // Look for the reply in the Transposition Table, and
+    // make sure that it is legal before suggesting it
+    MakeMove(pos, best);
+
+    if (   probeTTEntry(pos->posKey, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound)
+        && moveIsLegal(pos, ttMove))
+        ponder = ttMove;
+
+    TakeMove(pos);
+
+    return ponder;
+}
+
+static void initRootMoves(Thread *thread) {
+
+    Limits *const limits = thread->limits;
+    MoveList list = {0};
+    GenerateAllMoves(&thread->pos, &list);
+
+    // Nothing of the last search may survive, as the root moves are
+    // read even when there are none, such as from a mated position
+    thread->rootMoveCount = 0;
+    memset(thread->rootMoves, 0, sizeof(thread->rootMoves));
+
+    // Keep the legal moves which were asked for by searchmoves. When
+    // none of them are legal the whole move list is searched instead
+    for (int pass = 0; pass < 2 && !thread->rootMoveCount; pass++) {
+        for (int i = 0; i < list.count; i++) {
+
+            int move = list.moves[i].move, wanted = pass || !limits->searchMovesCount;
+
+            for (int j = 0; j < limits->searchMovesCount && !wanted; j++)
+                wanted = limits->searchMoves[j] == move;
+
+            if (!wanted)
+                continue;
+
+            RootMove *rm = &thread->rootMoves[thread->rootMoveCount++];
+            rm->move  = move;
+            rm->score = rm->previousScore = -INFINITE;
+            rm->nodes = 0;
+            rm->pv.length = 0;
+        }
+    }
+}
+
+static void sortRootMoves(RootMove *rootMoves, int count) {
+
+    // Stable insertion sort, so that root moves which have not
+    // raised alpha keep the order of the last iteration
+    for (int i = 1; i < count; i++) {
+
+        RootMove rm = rootMoves[i];
+        int j = i - 1;
+
+        for ( ; j >= 0 && (   rootMoves[j].score < rm.score
+                           || (   rootMoves[j].score == rm.score
+                               && rootMoves[j].previousScore < rm.previousScore)); j--)
+            rootMoves[j+1] = rootMoves[j];
+
+        rootMoves[j+1] = rm;
+    }
+}
+
+static RootMove* findRootMove(Thread *thread, int move) {
+
+    // Only the root moves of this and the later PV lines are searched.
+    // Those of the earlier lines are already at the front of the array
+    for (int i = thread->multiPV; i < thread->rootMoveCount; i++)
+        if (thread->rootMoves[i].move == move)
+            return &thread->rootMoves[i];
+
+    return NULL;
+}
+
 // Add a small random variance to draw scores, to avoid 3fold-blindness
 int valueDraw(SearchInfo *info) {
     return VALUE_DRAW + (2 * (info->nodes & 1)) - 1;
 }
 
-void ClearForSearch(Board *pos, SearchInfo *info) {
+void ClearForSearch(Thread *thread) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
+
     // Reset the tables used for move ordering
-    memset(pos->killers, 0, sizeof(KillerTable));
-    memset(pos->cmtable, 0, sizeof(CounterMoveTable));
-    memset(pos->mainHistory, 0, sizeof(HistoryTable));
-    memset(pos->continuation, 0, sizeof(ContinuationTable));
-    
+    memset(thread->killers, 0, sizeof(KillerTable));
+    memset(thread->cmtable, 0, sizeof(CounterMoveTable));
+    memset(thread->mainHistory, 0, sizeof(HistoryTable));
+    memset(thread->continuation, 0, sizeof(ContinuationTable));
+
+    // The first plies look back at entries of these stacks which they
+    // have not written, so they must not keep those of the last search
+    memset(info->staticEval, 0, sizeof(info->staticEval));
+    memset(info->historyScore, 0, sizeof(info->historyScore));
+    memset(info->currentMove, 0, sizeof(info->currentMove));
+    memset(info->currentPiece, 0, sizeof(info->currentPiece));
+
     pos->ply      = 0;
-    info->stop    = 0;
     info->nodes   = 0;
     info->fh      = 0;
     info->fhf     = 0;
     info->nullCut = 0;
     info->probCut = 0;
-    info->previousTimeReduction = 1.0;
+    info->bestMoveChanges = 0;
+
+    thread->pawnTable.probes = 0;
+    thread->pawnTable.hits   = 0;
+
+    thread->multiPV = 0;
 }
 
 void initLMRTable() {
@@ -73,54 +172,171 @@ void initLMRTable() {
             LMRTable[depth][played] = 0.75 + log(depth) * log(played) / 2.25;
 }
 
-void getBestMove(SearchInfo *info, Board *pos, Limits *limits, int *best) {
+static Thread* selectBestThread(Thread *threads) {
 
-    // Minor house keeping for starting a search
-    updateTTable(); // Table has an age component
-    TimeManagementInit(info, limits, pos->gamePly);
-    iterativeDeepening(pos, info, limits, best);
+    Thread *bestThread = &threads[0];
+
+    // Prefer the deepest completed search, and on equal depths the
+    // highest score. A Thread without a best move is never selected
+    for (int i = 1; i < threads->nthreads; i++) {
+
+        if (threads[i].bestMove == NONE_MOVE)
+            continue;
+
+        if (   threads[i].completedDepth > bestThread->completedDepth
+            || (   threads[i].completedDepth == bestThread->completedDepth
+                && threads[i].value > bestThread->value))
+            bestThread = &threads[i];
+    }
+
+    return bestThread;
 }
 
-void iterativeDeepening(Board *pos, SearchInfo *info, Limits *limits, int *best) {
+void getBestMove(Thread *threads, Board *pos, Limits *limits, int *best, int *ponder) {
 
-    double timeReduction = 1;
+    pthread_t pthreads[threads->nthreads];
 
-    // Return a book move if we have one
-    if (Options.PolyBook) {
+    // Minor house keeping for starting a search
+    updateTTable(); // Table has an age component
+    TimeManagementInit(&threads->info, limits, pos->gamePly);
+
+    // Return a book move if we have one. Under go infinite, or while
+    // pondering, the move could not be reported until a stop or a
+    // ponderhit anyway, and a pondered move may never be played
+    if (Options.PolyBook && !limits->limitedByNone && !threads->info.pondering) {
         int bookMove = GetBookMove(pos);
         if (bookMove != NONE_MOVE) {
-            *best = bookMove; return;
+            *best = bookMove, *ponder = NONE_MOVE; return;
         }
     }
 
-    ClearForSearch(pos, info);
+    // The threads search with their own copy of the limits, as the
+    // tablebase filter narrows the searchmoves of this search only,
+    // while bench and evalbook reuse their limits for every position
+    Limits searchLimits = *limits;
+
+    // Setup the thread pool with copies of the root position
+    newSearchThreadPool(threads, pos, &searchLimits);
+
+    // In a tablebase position only the moves which keep the best
+    // result are searched, passed on to the threads as searchmoves
+    if (probeSyzygyRoot(pos, &searchLimits))
+        threads->info.tbhits++;
+
+    // Launch the helper threads, which share only the Transposition Table,
+    // and then run the main thread's search in the current thread
+    for (int i = 1; i < threads->nthreads; i++)
+        pthread_create(&pthreads[i], NULL, &iterativeDeepening, &threads[i]);
+    iterativeDeepening(&threads[0]);
+
+    // Under go infinite, or while pondering, the best move may only be
+    // reported once the interface asks us to stop, or sends a ponderhit,
+    // even when the search has already ended by itself
+    while ((limits->limitedByNone || threads->info.pondering) && !threads->info.stop)
+        CheckPonderHit(&threads->info), usleep(1000);
+
+    // The main thread is done, the helpers must stop as well
+    stopThreadPool(threads);
+    for (int i = 1; i < threads->nthreads; i++)
+        pthread_join(pthreads[i], NULL);
+
+    Thread *const bestThread = selectBestThread(threads);
+    PVariation *const pv = &bestThread->rootMoves[0].pv;
+
+    // The book learning guesses the result of the game from our last score
+    if (bestThread->completedDepth)
+        RecordBookSearch(bestThread->value);
+
+    // A search stopped before its first iteration still plays a legal
+    // move. The reply we expect is the second move of the PV which led
+    // to our best move. An unfinished iteration may have cut that PV short
+    *best   = bestThread->bestMove != NONE_MOVE ? bestThread->bestMove
+            : threads->rootMoveCount ? threads->rootMoves[0].move : NONE_MOVE;
+    *ponder = pv->length > 1 && pv->line[0] == *best ? pv->line[1]
+            : *best != NONE_MOVE ? ponderMoveFromTT(&threads->pos, *best) : NONE_MOVE;
+}
+
+void* iterativeDeepening(void *vthread) {
+
+    Thread *const thread  = (Thread*) vthread;
+    SearchInfo *const info = &thread->info;
+    Limits *const limits  = thread->limits;
+
+    const int mainThread = thread->index == 0;
+    int value, multiPV;
+
+    ClearForSearch(thread);
+    initRootMoves(thread);
+    newSearchTimeManager(&thread->tm);
+
+    // There can not be more PV lines than there are root moves
+    multiPV = MAX(1, MIN(Options.MultiPV, thread->rootMoveCount));
 
     // Perform iterative deepening until exit conditions 
     for (info->depth = 1; info->depth <= MAX_PLY && !info->stop; info->depth++) {
 
-        // Perform a search for the current depth
-        info->values[info->depth] = aspirationWindow(pos, info, best);
+        for (int i = 0; i < thread->rootMoveCount; i++)
+            thread->rootMoves[i].previousScore = thread->rootMoves[i].score;
+
+        // Perform a search for the current depth, once for every PV line.
+        // Each line skips the root moves of the lines searched before it
+        for (thread->multiPV = 0; thread->multiPV < multiPV && !info->stop; thread->multiPV++) {
+            value = aspirationWindow(thread);
+            if (thread->multiPV == 0) info->values[info->depth] = value;
+        }
+
+        // Only a fully searched depth may be used as a result
+        if (!info->stop) {
+            thread->completedDepth = info->depth;
+            thread->value = info->values[info->depth];
+        }
+
+        // Helper threads only stop on the depth limit, or when signaled
+        if (!mainThread) {
+            if (limits->limitedByDepth && info->depth >= limits->depthLimit)
+                break;
+            continue;
+        }
+
+        // While pondering the clock is not ours, so only a depth
+        // limit can end the search until the interface tells more
+        CheckPonderHit(info);
+        if (info->pondering) {
+            if (limits->limitedByDepth && info->depth >= limits->depthLimit)
+                break;
+            continue;
+        }
 
         // Check for termination by any of the possible limits 
-        if (   (limits->limitedBySelf  && TerminateTimeManagement(pos, info, &timeReduction))
+        if (   (limits->limitedBySelf  && TerminateTimeManagement(thread))
             || (limits->limitedBySelf  && elapsedTime(info) > info->maximumTime - 10)
             || (limits->limitedByTime  && elapsedTime(info) > limits->timeLimit)
             || (limits->limitedByDepth && info->depth >= limits->depthLimit))
             break;
     }
 
-    info->previousTimeReduction = timeReduction;
+    // The next search of the game starts from what this one learned
+    if (mainThread && thread->completedDepth)
+        endSearchTimeManager(&thread->tm, thread->value);
+
+    return NULL;
 }
 
-int aspirationWindow(Board *pos, SearchInfo *info, int *best) {
+int aspirationWindow(Thread *thread) {
 
-    ASSERT(CheckBoard(pos));
+    SearchInfo *const info = &thread->info;
 
-    int alpha, beta, value, lastValue, delta;
-    PVariation *const pv = &pos->pv;
+    ASSERT(CheckBoard(&thread->pos));
 
-    // Create an aspiration window, unless still below the starting depth
-    lastValue = info->depth >= WindowDepth ? info->values[info->depth-1]       : -INFINITE;
+    int alpha, beta, value, lastValue, delta;
+    RootMove *const rootMoves = thread->rootMoves + thread->multiPV;
+    const int count = thread->rootMoveCount - thread->multiPV;
+    const int mainThread = thread->index == 0;
+    PVariation pv;
+
+    // Create an aspiration window around the last score of this PV line,
+    // unless still below the starting depth
+    lastValue = info->depth >= WindowDepth ? rootMoves[0].previousScore : -INFINITE;
     delta     = info->depth >= WindowDepth ? WindowSize + abs(lastValue) / 141 : -INFINITE;
     alpha     = info->depth >= WindowDepth ? MAX(-INFINITE, lastValue - delta) : -INFINITE;
     beta      = info->depth >= WindowDepth ? MIN( INFINITE, lastValue + delta) :  INFINITE;
@@ -132,30 +348,36 @@ int aspirationWindow(Board *pos, SearchInfo *info, int *best) {
         int adjustedDepth = MAX(1, info->depth - failedHighCnt);
 
         // Perform a search on the window, return if inside the window
-        value = search(alpha, beta, adjustedDepth, pos, info, pv, 0);
+        value = search(alpha, beta, adjustedDepth, thread, &pv, 0);
 
         if (info->stop)
             return value;
 
-        if (   (value > alpha && value < beta)
-            || (elapsedTime(info) >= WindowTimerMS))
-            uciReport(info, pos, alpha, beta, value);
+        // Bring the best root move of this PV line to the front
+        sortRootMoves(rootMoves, count);
+
+        // Only the main thread reports the search to the interface
+        if (    mainThread
+            && (   (value > alpha && value < beta)
+                || (elapsedTime(info) >= WindowTimerMS)))
+            uciReport(thread->threads, &rootMoves[0].pv, alpha, beta, value);
 
-        // Search failed low
-        if (value <= alpha) {
+        // Search failed low. A mated root scores -INFINITE, which
+        // no window can be widened beyond, so that search is final
+        if (value <= alpha && alpha > -INFINITE) {
             beta  = (alpha + beta) / 2;
             alpha = MAX(-INFINITE, value - delta);
             failedHighCnt = 0;
         }
 
         // Search failed high
-        else if (value >= beta) { 
+        else if (value >= beta && beta < INFINITE) {
             beta = MIN(INFINITE, value + delta);
             failedHighCnt++;
         }
 
         else {
-            *best = pos->pv.line[0];
+            if (thread->multiPV == 0) thread->bestMove = rootMoves[0].move;
             return value;
         }
 
@@ -164,7 +386,10 @@ int aspirationWindow(Board *pos, SearchInfo *info, int *best) {
     }
 }
 
-int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariation *pv, int height) {
+int search(int alpha, int beta, int depth, Thread *thread, PVariation *pv, int height) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
 
     ASSERT(CheckBoard(pos));
     ASSERT(beta>alpha);
@@ -172,7 +397,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
     int InCheck = KingSqAttacked(pos);
 
     if (depth <= 0 && !InCheck)
-        return qsearch(alpha, beta, depth, pos, info, pv, height);
+        return qsearch(alpha, beta, depth, thread, pv, height);
 
     const int PvNode   = (alpha != beta - 1);
     const int RootNode = (PvNode && pos->ply == 0);
@@ -183,16 +408,21 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
     int improving, extension, singularExt = 0, LMRflag = 0;
     int R, newDepth, rAlpha, rBeta, isQuiet, ttNoisy;
     int eval, value = -INFINITE, best = -INFINITE;
+    int tbValue, tbBound, syzygyMin = -INFINITE, syzygyMax = INFINITE;
     int move = NONE_MOVE, bestMove = NONE_MOVE, excludedMove = NONE_MOVE;
     int ttMove = NONE_MOVE, quiets[MAX_MOVES];
     MovePicker movePicker;
     PVariation lpv;
+    RootMove *rm = NULL;
+    uint64_t startNodes;
 
     // Ensure a new pv line
     pv->length = 0;
 
-    // Prefetch TTable as early as possible
+    // Prefetch TTable and Material Table as early as possible
     prefetchTTable(pos->posKey);
+    prefetchMaterialTable(&thread->materialTable, pos->materialKey);
+    prefetchPawnTable(&thread->pawnTable, pos->pawnKey);
 
     // Ensure positive depth
     depth = MAX(0, depth);
@@ -202,7 +432,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
     info->seldepth = (height == 0) ? 0 : MAX(info->seldepth, height);
 
     // Do we have time left on the clock?
-    if ((info->nodes & 1023) == 1023)
+    if ((info->nodes & 1023) == 1023 && thread->index == 0)
         CheckTime(info);
 
     if (!RootNode) {
@@ -211,7 +441,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
             return valueDraw(info);
 
         if (height >= MAX_PLY)
-            return EvalPosition(pos, &Table);
+            return EvalPosition(pos, thread);
 
         rAlpha = alpha > -INFINITE + height     ? alpha : -INFINITE + height;
         rBeta  =  beta <  INFINITE - height - 1 ?  beta :  INFINITE - height - 1;
@@ -232,17 +462,38 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
         }
     }
 
+    // Probe the Syzygy tablebases. Draws are exact, while wins and losses
+    // only bound the score, and cut off when outside of the window
+    if (probeSyzygyWDL(pos, depth, height, &tbValue, &tbBound)) {
+
+        info->tbhits++;
+
+        if (    tbBound == BOUND_EXACT
+            || (tbBound == BOUND_LOWER && tbValue >= beta)
+            || (tbBound == BOUND_UPPER && tbValue <= alpha)) {
+            storeTTEntry(pos->posKey, NONE_MOVE, valueToTT(tbValue, height), VALUE_NONE, MIN(depth + 6, MAX_PLY - 1), tbBound);
+            return tbValue;
+        }
+
+        // In PV nodes the search may not score beyond the known result
+        if (PvNode && tbBound == BOUND_LOWER)
+            syzygyMin = tbValue, alpha = MAX(alpha, tbValue);
+
+        if (PvNode && tbBound == BOUND_UPPER)
+            syzygyMax = tbValue;
+    }
+
     bonus = -info->historyScore[height-1] / HistoryDivisor;
 
     eval = info->staticEval[height] =
            ttHit && ttEval != VALUE_NONE            ?  ttEval
-         : info->currentMove[height-1] != NULL_MOVE ?  EvalPosition(pos, &Table) + bonus
+         : info->currentMove[height-1] != NULL_MOVE ?  EvalPosition(pos, thread) + bonus
                                                     : -info->staticEval[height-1] + 2 * TEMPO;
 
     improving = height >= 2 && eval > info->staticEval[height-2];
 
-    pos->killers[height+1][0] = NONE_MOVE;
-    pos->killers[height+1][1] = NONE_MOVE;
+    thread->killers[height+1][0] = NONE_MOVE;
+    thread->killers[height+1][1] = NONE_MOVE;
 
     if (RootNode)
         info->historyScore[height+4] = 0;
@@ -270,7 +521,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
         && !RootNode
         &&  depth <= RazorDepth
         &&  eval + RazorMargin <= alpha)
-        return qsearch(alpha, beta, depth, pos, info, pv, height);
+        return qsearch(alpha, beta, depth, thread, pv, height);
 
     if (   !PvNode
         && !InCheck
@@ -295,7 +546,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
 
         MakeNullMove(pos);
         info->currentMove[height] = NULL_MOVE;
-        value = -search( -beta, -beta + 1, depth-R, pos, info, &lpv, height+1);
+        value = -search( -beta, -beta + 1, depth-R, thread, &lpv, height+1);
         TakeNullMove(pos);
 
         if (value >= beta) {
@@ -309,7 +560,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
             info->nullMinPly = height + 3 * (depth-R) / 4;
             info->nullColor = pos->side;
 
-            int value2 = search( beta - 1, beta, depth-R, pos, info, &lpv, height);
+            int value2 = search( beta - 1, beta, depth-R, thread, &lpv, height);
 
             info->nullMinPly = 0;
 
@@ -327,7 +578,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
         rBeta = MIN(beta + ProbCutMargin[improving], INFINITE - MAX_PLY - 1);
 
         MoveList list = {0};
-        initNoisyMovePicker(&movePicker, info, &list);
+        initNoisyMovePicker(&movePicker, thread, &list);
         int ProbCutTried = 0;
 
         while (  (move = selectNextMove(&movePicker, pos, 1)) != NONE_MOVE
@@ -336,19 +587,17 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
             if (move == excludedMove)
                 continue;
 
-            else if (!MakeMove(pos, move))
-                continue;
-
+            MakeMove(pos, move);
             ProbCutTried += 1;
             info->currentMove[height] = move;
             info->currentPiece[height] = pieceType(pos->pieces[TOSQ(move)]);
 
             // First perform the qsearch to verify that the move maintain rBeta, 
             // if the qsearch held rBeta, perform the regular search.
-            value = -qsearch( -rBeta, -rBeta + 1, 0, pos, info, &lpv, height+1);
+            value = -qsearch( -rBeta, -rBeta + 1, 0, thread, &lpv, height+1);
 
             if (value >= rBeta)
-                value = -search( -rBeta, -rBeta + 1, depth-4, pos, info, &lpv, height+1);
+                value = -search( -rBeta, -rBeta + 1, depth-4, thread, &lpv, height+1);
 
             TakeMove(pos);
 
@@ -362,23 +611,32 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
         && !ttMove
         &&  depth >= IterativeDepth) {
 
-        search(alpha, beta, depth-7, pos, info, &lpv, height);
+        search(alpha, beta, depth-7, thread, &lpv, height);
 
         if ((ttHit = probeTTEntry(pos->posKey, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound)))
             ttValue = valueFromTT(ttValue, height);
     }
 
+    // At the root, every PV line starts from the best of its root moves
+    // in the last iteration. The TT entry only belongs to the first line
+    if (RootNode && info->depth > 1 && thread->rootMoveCount)
+        ttMove = thread->rootMoves[thread->multiPV].move;
+
     ttNoisy = ttMove && !moveIsQuiet(ttMove);
     MoveList list = {0};
-    initMovePicker(&movePicker, pos, info, &list, ttMove, height);
+    initMovePicker(&movePicker, thread, &list, ttMove, height);
     while ((move = selectNextMove(&movePicker, pos, skipQuiets)) != NONE_MOVE) {
 
         if (move == excludedMove)
             continue;
 
+        // Skip the root moves excluded by searchmoves, or owned by an earlier PV line
+        if (RootNode && !(rm = findRootMove(thread, move)))
+            continue;
+
         // Get history scores for quiet moves
         if ((isQuiet = moveIsQuiet(move)))
-            getHistoryScore(pos, info, move, height, &hist, &cmhist, &fmhist, &gcmhist, &gchmhist);
+            getHistoryScore(thread, move, height, &hist, &cmhist, &fmhist, &gcmhist, &gchmhist);
 
         if (   !RootNode
             && !excludedMove // Avoid recursive singular search
@@ -390,7 +648,7 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
 
             rBeta = ttValue - 2 * depth;
             excludedMove = move;
-            value = search( rBeta - 1, rBeta, depth / 2, pos, info, &lpv, height);
+            value = search( rBeta - 1, rBeta, depth / 2, thread, &lpv, height);
             excludedMove = NONE_MOVE;
 
             if (value < rBeta) {
@@ -403,18 +661,17 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
             else if (rBeta >= beta) {
 
                 if (isQuiet)
-                    updateKillerMoves(pos, height, move);
+                    updateKillerMoves(thread, height, move);
 
                 return rBeta;
             }
         }
 
-        if (!MakeMove(pos, move))
-            continue;  
-
+        MakeMove(pos, move);
         played += 1;
+        startNodes = info->nodes;
 
-        if (RootNode && elapsedTime(info) > WindowTimerMS)
+        if (RootNode && thread->index == 0 && elapsedTime(info) > WindowTimerMS)
             uciReportCurrentMove(move, played, info->depth);
 
         info->currentMove[height] = move;
@@ -470,23 +727,38 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
         // if the move fails high it will be re-searched at full depth.
         int d = clamp(newDepth-R, 1, newDepth);
         if (R != 1)
-            value = -search( -alpha-1, -alpha, d, pos, info, &lpv, height+1);
+            value = -search( -alpha-1, -alpha, d, thread, &lpv, height+1);
 
         // Do full depth search again on the null alpha window,
         // if LMR is skipped or fails high.
         if ((R != 1 && value > alpha && d != newDepth) || (R == 1 && (!PvNode || played > 1)))
-            value = -search( -alpha-1, -alpha, newDepth-1, pos, info, &lpv, height+1);
+            value = -search( -alpha-1, -alpha, newDepth-1, thread, &lpv, height+1);
         
         // For PvNodes only, do a full PV search on the normal window.
         if (PvNode && (played == 1 || (value > alpha && (RootNode || value < beta))))
-            value = -search( -beta, -alpha, newDepth-1, pos, info, &lpv, height+1);
+            value = -search( -beta, -alpha, newDepth-1, thread, &lpv, height+1);
         
         TakeMove(pos);
 
         if (info->stop)
             return VALUE_DRAW;
 
+        // Root moves keep their node count, and the score and PV when they are
+        // the first move or raise alpha. All the others sort behind them
+        if (RootNode) {
+            rm->nodes += info->nodes - startNodes;
+
+            if (played == 1 || value > alpha) {
+                rm->score = value;
+                rm->pv.length = 1 + lpv.length;
+                rm->pv.line[0] = move;
+                memcpy(rm->pv.line + 1, lpv.line, sizeof(int) * lpv.length);
+            }
+            else rm->score = -INFINITE;
+        }
+
         if (   RootNode
+            && thread->multiPV == 0
             && value > alpha
             && played > 1)
             info->bestMoveChanges++;
@@ -524,9 +796,13 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
               :      InCheck ? -INFINITE + height : VALUE_DRAW;
 
     if (best >= beta && moveIsQuiet(bestMove))
-        updateHistoryStats(pos, info, quiets, quietsTried, height, depth*depth);
+        updateHistoryStats(thread, quiets, quietsTried, height, depth*depth);
+
+    if (PvNode)
+        best = clamp(best, syzygyMin, syzygyMax);
 
-    if (!excludedMove) {
+    // Only the first PV line sees every root move, so it alone may store the root
+    if (!excludedMove && (!RootNode || thread->multiPV == 0)) {
         ttBound =  best >= beta       ? BOUND_LOWER
                  : PvNode && bestMove ? BOUND_EXACT : BOUND_UPPER;
         storeTTEntry(pos->posKey, bestMove, valueToTT(best, height), eval, depth, ttBound);
@@ -535,7 +811,10 @@ int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariat
     return best;
 }
 
-int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariation *pv, int height) {
+int qsearch(int alpha, int beta, int depth, Thread *thread, PVariation *pv, int height) {
+
+    Board *const pos = &thread->pos;
+    SearchInfo *const info = &thread->info;
 
     ASSERT(CheckBoard(pos));
     ASSERT(beta>alpha);
@@ -544,22 +823,24 @@ int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVaria
     PVariation lpv;
     pv->length = 0;
 
-    // Prefetch TTable as early as possible
+    // Prefetch TTable and Material Table as early as possible
     prefetchTTable(pos->posKey);
+    prefetchMaterialTable(&thread->materialTable, pos->materialKey);
+    prefetchPawnTable(&thread->pawnTable, pos->pawnKey);
 
     // Updates for UCI reporting
     info->nodes++;
     info->seldepth = MAX(info->seldepth, height);
 
     // Do we have time left on the clock?
-    if ((info->nodes & 1023) == 1023)
+    if ((info->nodes & 1023) == 1023 && thread->index == 0)
         CheckTime(info);
 
     if (posIsDrawn(pos, pos->ply))
         return VALUE_DRAW;
 
     if (pos->ply >= MAX_PLY)
-        return EvalPosition(pos, &Table);
+        return EvalPosition(pos, thread);
 
     const int PvNode = (alpha != beta - 1);
 
@@ -587,7 +868,7 @@ int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVaria
 
     best = info->staticEval[height] =
            ttHit && ttEval != VALUE_NONE            ?  ttEval
-         : info->currentMove[height-1] != NULL_MOVE ?  EvalPosition(pos, &Table)
+         : info->currentMove[height-1] != NULL_MOVE ?  EvalPosition(pos, thread)
                                                     : -info->staticEval[height-1] + 2 * TEMPO;
 
     if (ttHit) {
@@ -606,11 +887,10 @@ int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVaria
     futilityBase = best + QFutilityMargin;
 
     MoveList list = {0};
-    initNoisyMovePicker(&movePicker, info, &list);
+    initNoisyMovePicker(&movePicker, thread, &list);
     while ((move = selectNextMove(&movePicker, pos, 1)) != NONE_MOVE) {
 
-        moveIsBadCapture = (  !see(pos, move, 1)
-                            || badCapture(move, pos));
+        moveIsBadCapture = badCapture(move, pos);
 
         moveIsPruneable = (    moveIsBadCapture
                            && !move_canSimplify(move, pos)
@@ -618,8 +898,7 @@ int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVaria
 
         PieceOnTo = pos->pieces[TOSQ(move)];
 
-        if (!MakeMove(pos, move))
-            continue;
+        MakeMove(pos, move);
 
         if (   !InCheck
             && !KingSqAttacked(pos)
@@ -645,7 +924,7 @@ int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVaria
         info->currentMove[height] = move;
         info->currentPiece[height] = pieceType(pos->pieces[TOSQ(move)]);
 
-        value = -qsearch( -beta, -alpha, depth-1, pos, info, &lpv, height+1);
+        value = -qsearch( -beta, -alpha, depth-1, thread, &lpv, height+1);
         TakeMove(pos);
 
         if (info->stop)
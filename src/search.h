@@ -23,6 +23,8 @@
 
 #include "defs.h"
 
+enum { MAX_MULTIPV = 256 };
+
 enum {
  	DEPTH_QS_CHECKS     =  0,
  	DEPTH_QS_NO_CHECKS  = -1,
@@ -32,13 +34,14 @@ enum {
 struct SearchInfo {
 
 	double startTime, optimumTime, maximumTime;
-	double previousTimeReduction, bestMoveChanges;
+	double bestMoveChanges;
 
-	uint64_t nodes;
+	uint64_t nodes, tbhits;
 	float fh, fhf;
 
 	int depth, seldepth;
-	int quit, stop, timeset;
+	int quit, timeset;
+	volatile int stop, pondering, ponderhit;
 
 	int values[MAX_PLY];
 	int staticEval[MAX_PLY];
@@ -56,16 +59,22 @@ struct PVariation {
     int length;
 };
 
-void getBestMove(SearchInfo *info, Board *pos, Limits *limits, int *best);
-void iterativeDeepening(Board *pos, SearchInfo *info, Limits *limits, int *best);
+struct RootMove {
+    int move, score, previousScore;
+    uint64_t nodes;             // Nodes spent below this move, over all iterations
+    PVariation pv;
+};
+
+void getBestMove(Thread *threads, Board *pos, Limits *limits, int *best, int *ponder);
+void* iterativeDeepening(void *vthread);
 
-int aspirationWindow(Board *pos, SearchInfo *info, int *best);
-int search(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariation *pv, int height);
-int qsearch(int alpha, int beta, int depth, Board *pos, SearchInfo *info, PVariation *pv, int height);
+int aspirationWindow(Thread *thread);
+int search(int alpha, int beta, int depth, Thread *thread, PVariation *pv, int height);
+int qsearch(int alpha, int beta, int depth, Thread *thread, PVariation *pv, int height);
 
 void initLMRTable();
 int valueDraw(SearchInfo *info);
-void ClearForSearch(Board *pos, SearchInfo *info);
+void ClearForSearch(Thread *thread);
 
 static const int BetaPruningDepth = 5;
 static const int BetaMargin = 85;
@@ -0,0 +1,185 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ *
+ *  Copyright (C) 2019 Roberto Martinez
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bitboards.h"
+#include "board.h"
+#include "defs.h"
+#include "makemove.h"
+#include "movegen.h"
+#include "syzygy.h"
+#include "ttable.h"
+#include "uci.h"
+
+#if defined(USE_SYZYGY)
+
+#include "fathom/tbprobe.h"
+
+// Arguments shared by every Fathom probe, built from our bitboards.
+// Fathom numbers the squares like our 64 square bitboards, a1 = 0
+#define SYZYGY_BOARD(pos)                                              \
+    (pos)->colourBB[WHITE], (pos)->colourBB[BLACK],                    \
+    (pos)->pieceBB[wK] | (pos)->pieceBB[bK],                           \
+    (pos)->pieceBB[wQ] | (pos)->pieceBB[bQ],                           \
+    (pos)->pieceBB[wR] | (pos)->pieceBB[bR],                           \
+    (pos)->pieceBB[wB] | (pos)->pieceBB[bB],                           \
+    (pos)->pieceBB[wN] | (pos)->pieceBB[bN],                           \
+    (pos)->pieceBB[wP] | (pos)->pieceBB[bP]
+
+#define SYZYGY_EP(pos) ((pos)->enPas == NO_SQ ? 0 : SQ64((pos)->enPas))
+
+static const unsigned SyzygyPromotes[PIECE_TYPE_NB] = {
+    TB_PROMOTES_NONE, TB_PROMOTES_NONE, TB_PROMOTES_KNIGHT,
+    TB_PROMOTES_BISHOP, TB_PROMOTES_ROOK, TB_PROMOTES_QUEEN, TB_PROMOTES_NONE
+};
+
+static int syzygyRootRank(unsigned result) {
+
+    // Wins sort by the shortest distance to zeroing the fifty move
+    // counter, losses by the longest one. Cursed wins and blessed
+    // losses are draws, but still better or worse than a plain draw
+    unsigned wdl = TB_GET_WDL(result), dtz = TB_GET_DTZ(result);
+
+    return wdl == TB_WIN  ?  2000 - (int)dtz
+         : wdl == TB_LOSS ? -2000 + (int)dtz : (int)wdl - TB_DRAW;
+}
+
+static int syzygyMatchesMove(unsigned result, int move) {
+
+    int promoted = PROMOTED(move);
+
+    return   TB_GET_FROM(result) == (unsigned)SQ64(FROMSQ(move))
+        &&   TB_GET_TO(result)   == (unsigned)SQ64(TOSQ(move))
+        &&   TB_GET_PROMOTES(result) == SyzygyPromotes[promoted ? pieceType(promoted) : 0];
+}
+
+void initSyzygy(char *path) {
+
+    // An empty path only unloads the tablebases, which tb_init() handles
+    if (!tb_init(path))
+        printf("info string failed to load Syzygy tablebases from %s\n", path);
+    else if (!*path)
+        printf("info string Syzygy tablebases unloaded\n");
+    else
+        printf("info string found %u piece Syzygy tablebases\n", TB_LARGEST);
+
+    fflush(stdout);
+}
+
+int probeSyzygyWDL(Board *pos, int depth, int height, int *value, int *bound) {
+
+    int cardinality = popcount(pos->colourBB[COLOUR_NB]);
+
+    // Fathom only probes WDL right after a capture or a pawn move, and never
+    // with castling rights. The root is left to probeSyzygyRoot(), and the
+    // largest tables are only probed from the minimum depth onwards
+    if (   height == 0
+        || pos->castlePerm
+        || pos->fiftyMove
+        || cardinality > (int)TB_LARGEST
+        || (cardinality == (int)TB_LARGEST && depth < SyzygyProbeDepth))
+        return 0;
+
+    unsigned result = tb_probe_wdl(SYZYGY_BOARD(pos), 0, 0, SYZYGY_EP(pos), pos->side == WHITE);
+
+    if (result == TB_RESULT_FAILED)
+        return 0;
+
+    // Cursed wins and blessed losses are draws under the fifty move rule.
+    // Wins and losses depend on the distance to mate, so they only bound
+    // the score, while every draw is exact
+    *value = result == TB_WIN  ?  VALUE_TB_WIN - height
+           : result == TB_LOSS ? -VALUE_TB_WIN + height : VALUE_DRAW;
+
+    *bound = result == TB_WIN  ? BOUND_LOWER
+           : result == TB_LOSS ? BOUND_UPPER : BOUND_EXACT;
+
+    return 1;
+}
+
+int probeSyzygyRoot(Board *pos, Limits *limits) {
+
+    unsigned results[TB_MAX_MOVES], result;
+    int ranks[MAX_MOVES], moves[MAX_MOVES], count = 0, best = -INFINITE;
+
+    if (   pos->castlePerm
+        || popcount(pos->colourBB[COLOUR_NB]) > (int)TB_LARGEST)
+        return 0;
+
+    // Unlike the WDL probes, this is not thread safe,
+    // so it runs once, before the search threads start
+    result = tb_probe_root(SYZYGY_BOARD(pos), pos->fiftyMove, 0, SYZYGY_EP(pos),
+                           pos->side == WHITE, results);
+
+    if (   result == TB_RESULT_FAILED
+        || result == TB_RESULT_CHECKMATE
+        || result == TB_RESULT_STALEMATE)
+        return 0;
+
+    MoveList list = {0};
+    GenerateAllMoves(pos, &list);
+
+    // Rank every root move still allowed by searchmoves
+    for (int i = 0; i < list.count; i++) {
+
+        int move = list.moves[i].move, allowed = !limits->searchMovesCount;
+
+        for (int j = 0; j < limits->searchMovesCount && !allowed; j++)
+            allowed = limits->searchMoves[j] == move;
+
+        for (int j = 0; allowed && results[j] != TB_RESULT_FAILED; j++) {
+            if (syzygyMatchesMove(results[j], move)) {
+                moves[count] = move, ranks[count] = syzygyRootRank(results[j]);
+                best = MAX(best, ranks[count++]);
+                break;
+            }
+        }
+    }
+
+    if (!count)
+        return 0;
+
+    // Only the best ranked moves are left for the search
+    limits->searchMovesCount = 0;
+    for (int i = 0; i < count; i++)
+        if (ranks[i] == best)
+            limits->searchMoves[limits->searchMovesCount++] = moves[i];
+
+    return 1;
+}
+
+#else
+
+void initSyzygy(char *path) {
+    if (*path) printf("info string Syzygy support was not compiled in, ignoring %s\n", path);
+    fflush(stdout);
+}
+
+int probeSyzygyWDL(Board *pos, int depth, int height, int *value, int *bound) {
+    (void)pos, (void)depth, (void)height, (void)value, (void)bound;
+    return 0;
+}
+
+int probeSyzygyRoot(Board *pos, Limits *limits) {
+    (void)pos, (void)limits;
+    return 0;
+}
+
+#endif
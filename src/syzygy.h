@@ -0,0 +1,31 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ *
+ *  Copyright (C) 2019 Roberto Martinez
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.h"
+
+// Probing is only compiled in with USE_SYZYGY, which needs Fathom's
+// tbprobe.c and tbprobe.h in src/fathom (see the syzygy make target).
+// Without it, the probes below always fail and cost nothing.
+
+static const int SyzygyProbeDepth = 1;
+
+void initSyzygy(char *path);
+int probeSyzygyWDL(Board *pos, int depth, int height, int *value, int *bound);
+int probeSyzygyRoot(Board *pos, Limits *limits);
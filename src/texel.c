@@ -24,11 +24,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "board.h"
 #include "defs.h"
 #include "evaluate.h"
 #include "hashkeys.h"
 #include "search.h"
 #include "texel.h"
+#include "thread.h"
 #include "time.h"
 #include "ttable.h"
 #include "uci.h"
@@ -106,7 +108,7 @@ void runTexelTuning() {
     printf("\nTUNER WILL BE TUNING %d TERMS...", NTERMS);
 
     printf("\n\nSETTING TABLE SIZE TO 1MB FOR SPEED...");
-    initTTable(1);
+    initTTable(1, 1);
 
     printf("\n\nALLOCATING MEMORY FOR TEXEL ENTRIES [%dMB]...",
            (int)(NPOSITIONS * sizeof(TexelEntry) / (1024 * 1024)));
@@ -165,18 +167,27 @@ void initTexelEntries(TexelEntry *tes, Board *pos) {
 
     char line[256];
     int i, j, k, eval, coeffs[NTERMS];
-    FILE *fin = fopen("book.epd", "r");
+    PackedBoard packed;
+    Thread *thread = createThreadPool(1);
+
+    // A book of packed positions skips parsing the FENs entirely
+    FILE *fin = fopen("book.packed", "rb");
+    const int isPacked = fin != NULL;
+
+    if (!isPacked)
+        fin = fopen("book.epd", "r");
 
     if (fin == NULL) {
-        printf("Unable to open file\n");
+        printf("Unable to open book.packed or book.epd\n");
         exit(EXIT_FAILURE);
     }
 
     // Create a TexelEntry for each FEN
     for (i = 0; i < NPOSITIONS; i++) {
 
-        // Read next position from the FEN file
-        if (fgets(line, 256, fin) == NULL) {
+        // Read next position from the packed or the FEN file
+        if (isPacked ? fread(&packed, sizeof(PackedBoard), 1, fin) != 1
+                     : fgets(line, 256, fin) == NULL) {
             printf("Unable to read line #%d\n", i);
             exit(EXIT_FAILURE);
         }
@@ -185,6 +196,20 @@ void initTexelEntries(TexelEntry *tes, Board *pos) {
         if ((i + 1) % 100000 == 0 || i == NPOSITIONS - 1)
             printf("\rINITIALIZING TEXEL ENTRIES FROM FENS...  [%7d OF %7d]", i + 1, NPOSITIONS);
 
+        if (isPacked) {
+
+            if (packed.result == PACKED_NO_RESULT) {
+                printf("No result for position #%d\n", i);
+                exit(EXIT_FAILURE);
+            }
+
+            unpackBoard(&packed, pos);
+            tes[i].result = packed.result / 2.0;
+            tes[i].eval = pos->side == WHITE ? packed.eval : -packed.eval;
+        }
+
+        else {
+
         // Fetch and cap a white POV search
         tes[i].eval = atoi(strstr(line, "] ") + 2);
         eval = tes[i].eval;
@@ -199,6 +224,8 @@ void initTexelEntries(TexelEntry *tes, Board *pos) {
         // Setup the given position
         ParseFen(strstr(line, "] ") + ((eval<=-10000) ? 9 : 8), pos);
 
+        }
+
         // Determine the game phase based on remaining material
         tes[i].phase = 24 - 4 * (pos->pceNum[wQ] + pos->pceNum[bQ])
                           - 2 * (pos->pceNum[wR] + pos->pceNum[bR])
@@ -214,7 +241,7 @@ void initTexelEntries(TexelEntry *tes, Board *pos) {
 
         // Vectorize the evaluation coefficients
         T = EmptyTrace;
-        EvalPosition(pos);
+        EvalPosition(pos, thread);
         initCoefficients(coeffs);
 
         // Count up the non zero coefficients
@@ -234,6 +261,7 @@ void initTexelEntries(TexelEntry *tes, Board *pos) {
     }
 
     fclose(fin);
+    deleteThreadPool(thread);
 }
 
 void initCoefficients(int coeffs[NTERMS]) {
@@ -0,0 +1,124 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ * 
+ *  Copyright (C) 2019 Roberto Martinez
+ *  Copyright (C) 2019 Andrew Grant
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// thread.c
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "defs.h"
+#include "pawns.h"
+#include "search.h"
+#include "thread.h"
+#include "time.h"
+#include "uci.h"
+
+Thread* createThreadPool(int nthreads) {
+
+    Thread *threads = calloc(nthreads, sizeof(Thread));
+
+    // Each Thread knows its own index and has access to the
+    // whole pool, the first Thread acts as the main thread
+    for (int i = 0; i < nthreads; i++) {
+        threads[i].index = i;
+        threads[i].nthreads = nthreads;
+        threads[i].threads = threads;
+        initPawnTable(&threads[i].pawnTable, Options.PawnHash);
+        initTimeManager(&threads[i].tm);
+    }
+
+    return threads;
+}
+
+void deleteThreadPool(Thread *threads) {
+
+    for (int i = 0; i < threads->nthreads; i++)
+        freePawnTable(&threads[i].pawnTable);
+
+    free(threads);
+}
+
+void resizePawnTables(Thread *threads, uint64_t MB) {
+
+    // Every Thread owns a Pawn Hash Table of the same size
+    for (int i = 0; i < threads->nthreads; i++)
+        initPawnTable(&threads[i].pawnTable, MB);
+}
+
+void newSearchThreadPool(Thread *threads, Board *pos, Limits *limits) {
+
+    // Every Thread searches its own copy of the root position. The
+    // time management has already been set up for the main thread,
+    // so copy over the clock information for the helpers as well.
+
+    for (int i = 0; i < threads->nthreads; i++) {
+
+        cloneBoard(&threads[i].pos, threads[i].history, pos);
+
+        threads[i].limits = limits;
+        threads[i].bestMove = NONE_MOVE;
+        threads[i].value = -INFINITE;
+        threads[i].completedDepth = 0;
+        threads[i].info.tbhits = 0;
+
+        if (i == 0) continue;
+
+        threads[i].info.timeset = 0;
+        threads[i].info.startTime = threads->info.startTime;
+        threads[i].info.optimumTime = threads->info.optimumTime;
+        threads[i].info.maximumTime = threads->info.maximumTime;
+    }
+}
+
+void clearStopThreadPool(Thread *threads) {
+
+    // Clear the stop signal of the previous search. The search is not
+    // running yet, so a stop from the interface can no longer be lost
+    for (int i = 0; i < threads->nthreads; i++)
+        threads[i].info.stop = 0;
+}
+
+void stopThreadPool(Thread *threads) {
+
+    // Signal every Thread to abort the current search
+    for (int i = 0; i < threads->nthreads; i++)
+        threads[i].info.stop = 1;
+}
+
+uint64_t nodesSearchedThreadPool(Thread *threads) {
+
+    uint64_t nodes = 0ull;
+
+    for (int i = 0; i < threads->nthreads; i++)
+        nodes += threads[i].info.nodes;
+
+    return nodes;
+}
+
+uint64_t tbhitsThreadPool(Thread *threads) {
+
+    uint64_t tbhits = 0ull;
+
+    for (int i = 0; i < threads->nthreads; i++)
+        tbhits += threads[i].info.tbhits;
+
+    return tbhits;
+}
@@ -0,0 +1,66 @@
+/*
+ *  PayFleens is a UCI chess engine by Roberto Martinez.
+ * 
+ *  Copyright (C) 2019 Roberto Martinez
+ *  Copyright (C) 2019 Andrew Grant
+ *
+ *  PayFleens is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  PayFleens is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "board.h"
+#include "defs.h"
+#include "endgame.h"
+#include "evaluate.h"
+#include "pawns.h"
+#include "search.h"
+#include "time.h"
+
+struct Thread {
+
+    Board pos;
+    Undo history[MAXGAMEMOVES]; // The game history stack of pos
+    SearchInfo info;
+    Limits *limits;
+
+    evalInfo ei;
+    Material_Table materialTable;
+    Pawn_Table pawnTable;
+
+    KillerTable killers;
+    CounterMoveTable cmtable;
+    HistoryTable mainHistory;
+    ContinuationTable continuation;
+
+    int bestMove, value, completedDepth;
+    TimeManager tm;                // Only used by the main thread
+
+    int multiPV;                   // The PV line being searched at the root
+    int rootMoveCount;             // Legal root moves, or only the searchmoves
+    RootMove rootMoves[MAX_MOVES]; // Sorted by score between searches
+
+    int index, nthreads;
+    Thread *threads;
+};
+
+Thread* createThreadPool(int nthreads);
+void deleteThreadPool(Thread *threads);
+void resizePawnTables(Thread *threads, uint64_t MB);
+void newSearchThreadPool(Thread *threads, Board *pos, Limits *limits);
+void clearStopThreadPool(Thread *threads);
+void stopThreadPool(Thread *threads);
+uint64_t nodesSearchedThreadPool(Thread *threads);
+uint64_t tbhitsThreadPool(Thread *threads);
@@ -22,20 +22,19 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <string.h>
 
 #include "board.h"
 #include "defs.h"
 #include "time.h"
 #include "search.h"
+#include "thread.h"
 #include "uci.h"
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 #else
 #include <sys/time.h>
-#include <sys/select.h>
-#include <string.h>
 #endif
 
 double getTimeMs() {
@@ -57,67 +56,29 @@ double elapsedTime(SearchInfo *info) {
     return getTimeMs() - info->startTime;
 }
 
-// http://home.arcor.de/dreamlike/chess/
-int InputWaiting() {
-#ifndef WIN32
-    fd_set readfds;
-    struct timeval tv;
-    FD_ZERO (&readfds);
-    FD_SET (fileno(stdin), &readfds);
-    tv.tv_sec = 0; tv.tv_usec = 0;
-    select(16, &readfds, 0, 0, &tv);
+void CheckPonderHit(SearchInfo *info) {
 
-    return (FD_ISSET(fileno(stdin), &readfds));
-#else
-    static int init = 0, pipe;
-    static HANDLE inh;
-    DWORD dw;
-
-    if (!init) {
-        init = 1;
-        inh = GetStdHandle(STD_INPUT_HANDLE);
-        pipe = !GetConsoleMode(inh, &dw);
-        if (!pipe) {
-            SetConsoleMode(inh, dw & ~(ENABLE_MOUSE_INPUT|ENABLE_WINDOW_INPUT));
-            FlushConsoleInputBuffer(inh);
-        }
-    }
-    if (pipe) {
-        if (!PeekNamedPipe(inh, NULL, 0, NULL, &dw, NULL)) return 1;
-        return dw;
-    } else {
-        GetNumberOfConsoleInputEvents(inh, &dw);
-        return dw <= 1 ? 0 : dw;
+    // The UCI thread only flags a ponderhit, and the main thread takes
+    // over the clock here, so a running search never sees it change under
+    // it. The budget itself was already set up at the go command
+    if (info->ponderhit) {
+        info->startTime = getTimeMs();
+        info->ponderhit = info->pondering = 0;
     }
-#endif
 }
 
-void ReadInput(SearchInfo *info) {
-    int  bytes;
-    char input[256] = "", *endc;
-
-    if (InputWaiting()) {
-        info->stop = 1;
-        do {
-            bytes = read(fileno(stdin), input, 256);
-        } while (bytes < 0);
+void CheckTime(SearchInfo *info) {
 
-        endc = strchr(input,'\n');
-        if (endc) *endc = 0;
+    CheckPonderHit(info);
 
-        return;
-    }
-}
-
-void CheckTime(SearchInfo *info) {
-    // .. check if time up, or interrupt from GUI
+    // Stop once the time is up. A stop from the interface is
+    // signaled by the UCI thread directly through info->stop
     if (   info->timeset 
+        && !info->pondering
         && info->depth > 1 
         && elapsedTime(info) > info->maximumTime - 10) {
         info->stop = 1;
     }
-
-    ReadInput(info);
 }
 
 double move_importance(int ply) {
@@ -146,6 +107,27 @@ double remaining(int T, double myTime, double slowMover, int movesToGo, int ply)
     return myTime * MIN(ratio1, ratio2);
 }
 
+void initTimeManager(TimeManager *tm) {
+
+    // Forget everything, as on a new game
+    memset(tm, 0, sizeof(TimeManager));
+    tm->previousTimeReduction = 1.0;
+    tm->previousValue = VALUE_NONE;
+    newSearchTimeManager(tm);
+}
+
+void newSearchTimeManager(TimeManager *tm) {
+    tm->lastBestMove = NONE_MOVE;
+    tm->lastBestMoveDepth = 0;
+    tm->bestMoveChanges = 0;
+    tm->timeReduction = 1.0;
+}
+
+void endSearchTimeManager(TimeManager *tm, int value) {
+    tm->previousTimeReduction = tm->timeReduction;
+    tm->previousValue = value;
+}
+
 void TimeManagementInit(SearchInfo *info, Limits *limits, int ply) {
 
     double minThinkingTime = Options.MinThinkingTime;
@@ -186,37 +168,47 @@ void TimeManagementInit(SearchInfo *info, Limits *limits, int ply) {
     }
 }
 
-int TerminateTimeManagement(Board *pos, SearchInfo *info, double *timeReduction) {
+int TerminateTimeManagement(Thread *thread) {
 
-    int completedDepth, lastBestMoveDepth, lastBestMove = NONE_MOVE;
-    double TimeRdction = 1, totBestMoveChanges = 0;
+    TimeManager *const tm  = &thread->tm;
+    SearchInfo *const info = &thread->info;
+    RootMove *const best   = &thread->rootMoves[0];
 
-    if (info->stop) 
-        return 1;
+    const int depth = thread->completedDepth;
+    const int value = info->values[depth];
 
-    if (!info->stop)
-        completedDepth = info->depth;
+    if (info->stop)
+        return 1;
 
-    if (pos->pv.line[0] != lastBestMove) {
-        lastBestMove = pos->pv.line[0];
-        lastBestMoveDepth = info->depth;
+    // Remember the depth at which the best move last changed, and
+    // let the changes of the older iterations fade out by halves
+    if (best->move != tm->lastBestMove) {
+        tm->lastBestMove = best->move;
+        tm->lastBestMoveDepth = depth;
     }
 
-    totBestMoveChanges /= 2;
+    tm->bestMoveChanges = tm->bestMoveChanges / 2 + info->bestMoveChanges;
+    info->bestMoveChanges = 0;
 
-    int previousScore = info->depth == 1 ? 32000 : info->values[info->depth-1];
-    double fallingEval = (383 + 19 * (previousScore - info->values[info->depth])) / 692.0;
+    // Think longer when the score falls, compared both to the
+    // last search and to the iteration of three depths ago
+    int lastValue = tm->previousValue == VALUE_NONE ? value : tm->previousValue;
+    int iterValue = info->values[MAX(1, depth - 3)];
+    double fallingEval = (383 + 10 * (lastValue - value) + 9 * (iterValue - value)) / 692.0;
     fallingEval = clamp(fallingEval, 0.5, 1.5);
 
-    TimeRdction = lastBestMoveDepth + 9 < completedDepth ? 1.97 : 0.98;
-    double reduction = (1.36 + info->previousTimeReduction) / (2.29 * TimeRdction);
+    // Think shorter when the best move has held for many iterations
+    tm->timeReduction = tm->lastBestMoveDepth + 9 < depth ? 1.97 : 0.98;
+    double reduction = (1.36 + tm->previousTimeReduction) / (2.29 * tm->timeReduction);
 
-    *timeReduction = TimeRdction;
-    totBestMoveChanges += info->bestMoveChanges;
-    info->bestMoveChanges = 0;
+    // Think longer when the best move keeps changing
+    double bestMoveInstability = 1 + tm->bestMoveChanges;
+
+    // Think shorter when the best move took most of the nodes, longer otherwise
+    double nodeFraction = (double) best->nodes / MAX(1, info->nodes);
+    double nodeFactor = clamp(2.0 * (1.0 - nodeFraction) + 0.4, 0.5, 1.5);
 
-    double bestMoveInstability = 1 + totBestMoveChanges;
-    double cutoff = info->optimumTime * fallingEval * reduction * bestMoveInstability;
+    double cutoff = info->optimumTime * fallingEval * reduction * bestMoveInstability * nodeFactor;
 
-    return elapsedTime(info) > cutoff;
-}
\ No newline at end of file
+    return elapsedTime(info) > MIN(cutoff, info->maximumTime);
+}
@@ -22,6 +22,17 @@
 
 enum { OptimumTime, MaxTime };
 
+struct TimeManager {
+
+    // Stability of the best move over the iterations of this search
+    int lastBestMove, lastBestMoveDepth;
+    double bestMoveChanges, timeReduction;
+
+    // Carried over from the last search of the game
+    double previousTimeReduction;
+    int previousValue;
+};
+
 static const int MoveHorizon   = 50;
 static const double MaxRatio   = 7.3;
 static const double StealRatio = 0.34;
@@ -31,9 +42,12 @@ double elapsedTime(SearchInfo *info);
 double move_importance(int ply);
 double remaining(int T, double myTime, double slowMover, int movesToGo, int ply);
 
+void initTimeManager(TimeManager *tm);
+void newSearchTimeManager(TimeManager *tm);
+void endSearchTimeManager(TimeManager *tm, int value);
+
 void TimeManagementInit(SearchInfo *info, Limits *limits, int ply);
-int TerminateTimeManagement(Board *pos, SearchInfo *info, double *timeReduction);
+int TerminateTimeManagement(Thread *thread);
 
-int InputWaiting();
-void ReadInput(SearchInfo *info);
+void CheckPonderHit(SearchInfo *info);
 void CheckTime(SearchInfo *info);
\ No newline at end of file
@@ -20,26 +20,77 @@
 // ttable.c
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
 #include "ttable.h"
 #include "defs.h"
 
 TTable TT; // The Global Transposition Table
 
-void clearTTable() {
+static void* clearTTableSlice(void *vslice) {
+
+    // Each thread wipes an equal slice of the table. Besides being
+    // faster, this spreads the first touch of the pages over all of the
+    // threads, so the Kernel places them across the used NUMA nodes
+
+    int *slice = (int*) vslice;
+    uint64_t size   = sizeof(TT_Cluster) * (TT.hashMask + 1u);
+    uint64_t start  = size * slice[0] / slice[1];
+    uint64_t end    = size * (slice[0] + 1) / slice[1];
+
+    memset((char*) TT.clusters + start, 0, end - start);
+
+    return NULL;
+}
+
+void clearTTable(int nthreads) {
 
     // Wipe the Transposition Table in preperation for a new game.
     // The Hash Mask is known to be one less than the size
 
-    memset(TT.clusters, 0, sizeof(TT_Cluster) * (TT.hashMask + 1u));
+    pthread_t pthreads[nthreads];
+    int slices[nthreads][2];
+
+    for (int i = 0; i < nthreads; i++) {
+        slices[i][0] = i, slices[i][1] = nthreads;
+        pthread_create(&pthreads[i], NULL, &clearTTableSlice, &slices[i]);
+    }
+
+    for (int i = 0; i < nthreads; i++)
+        pthread_join(pthreads[i], NULL);
+
+    TT.generation = 0;
 }
 
-void initTTable(uint64_t MB) {
+void* allocHugePages(uint64_t size) {
+
+#if defined(__linux__)
+
+    // Align the table to the 2MB page size, and ask the Kernel to back
+    // it with huge pages in order to reduce TLB misses on larger sizes.
+    // If either fails we still end up with a table using regular pages
 
-    uint64_t keySize = 16ull;
+    void *memory = aligned_alloc(TT_HUGE_PAGE_SIZE, MAX(size, TT_HUGE_PAGE_SIZE));
+    if (memory != NULL) madvise(memory, size, MADV_HUGEPAGE);
+    else memory = malloc(size);
+
+    return memory;
+
+#else
+    return malloc(size);
+#endif
+}
+
+void initTTable(uint64_t MB, int nthreads) {
+
+    uint64_t keySize = 16ull, size;
 
     // Cleanup memory when resizing the table
     if (TT.hashMask) free(TT.clusters);
@@ -57,9 +108,10 @@ void initTTable(uint64_t MB) {
 
     // Allocate the TTClusters and save the lookup mask
     TT.hashMask = (1ull << keySize) - 1u;
-    TT.clusters = malloc(sizeof(TT_Cluster) * (1ull << keySize));
+    size = sizeof(TT_Cluster) * (1ull << keySize);
+    TT.clusters = allocHugePages(size);
 
-    clearTTable(); // Clear the table and load everything into the cache
+    clearTTable(nthreads); // Clear the table and load everything into the cache
 }
 
 void prefetchTTable(uint64_t key) {
@@ -82,6 +134,24 @@ void updateTTable() {
     assert(!(TT.generation & TT_MASK_BOUND));
 }
 
+static uint64_t packTTData(int move, int value, int eval) {
+
+    // The move uses the lower 25 bits, followed by
+    // the value and static eval as 16 bit integers
+
+    return  (uint64_t)(move & 0x1FFFFFF)
+         | ((uint64_t)(uint16_t)value << 25)
+         | ((uint64_t)(uint16_t)eval  << 41);
+}
+
+static uint64_t loadTTWord(uint64_t *word) {
+    return __atomic_load_n(word, __ATOMIC_RELAXED);
+}
+
+static void storeTTWord(uint64_t *word, uint64_t value) {
+    __atomic_store_n(word, value, __ATOMIC_RELAXED);
+}
+
 int hashfullTTable() {
 
     // Take a sample of the first thousand clusters in the table
@@ -90,34 +160,46 @@ int hashfullTTable() {
 
     int cnt = 0;
 
-    for (int i = 0; i < 1000; i++)
-        for (int j = 0; j < TT_CLUSTER_NB; j++)
-            cnt += (TT.clusters[i].entry[j].generation & TT_MASK_BOUND) != BOUND_NONE
-                && (TT.clusters[i].entry[j].generation & TT_MASK_AGE) == TT.generation;
+    for (int i = 0; i < 1000; i++) {
+        for (int j = 0; j < TT_CLUSTER_NB; j++) {
+
+            TT_Entry *entry = &TT.clusters[i].entry[j];
+            uint8_t generation = loadTTWord(&entry->key) ^ loadTTWord(&entry->data);
+
+            cnt += (generation & TT_MASK_BOUND) != BOUND_NONE
+                && (generation & TT_MASK_AGE) == TT.generation;
+        }
+    }
 
     return cnt / TT_CLUSTER_NB;
 }
 
 int probeTTEntry(uint64_t key, int *move, int *value, int *eval, int *depth, int *bound) {
 
-    const uint16_t key16 = key >> 48;
     TT_Entry *entry = TT.clusters[key & TT.hashMask].entry;
 
-    // Search for a matching key16 signature
+    // Search for a matching key signature. Entries are written without
+    // locks, so the key is stored XOR'ed with the data. An entry torn by
+    // a concurrent write from another Thread will then fail to match
     for (int i = 0; i < TT_CLUSTER_NB; i++) {
-        if (entry[i].key16 == key16) {
-
-            // Update age but retain bound type
-            entry[i].generation = TT.generation | (entry[i].generation & TT_MASK_BOUND);
-
-            // Copy over the TTEntry and signal success
-            *move  = entry[i].move;
-            *value = entry[i].value;
-            *eval  = entry[i].eval;
-            *depth = entry[i].depth;
-            *bound = entry[i].generation & TT_MASK_BOUND;
-            return 1;
-        }
+
+        uint64_t data = loadTTWord(&entry[i].data);
+        uint64_t word = loadTTWord(&entry[i].key) ^ data;
+
+        if ((word ^ key) & TT_MASK_KEY)
+            continue;
+
+        // Update age but retain bound type
+        word = (word & ~(uint64_t)TT_MASK_AGE) | TT.generation;
+        storeTTWord(&entry[i].key, word ^ data);
+
+        // Copy over the TTEntry and signal success
+        *move  = (int)(data & 0x1FFFFFF);
+        *value = (int16_t)(data >> 25);
+        *eval  = (int16_t)(data >> 41);
+        *depth = (int8_t)(word >> 8);
+        *bound = word & TT_MASK_BOUND;
+        return 1;
     }
 
     return 0;
@@ -126,50 +208,53 @@ int probeTTEntry(uint64_t key, int *move, int *value, int *eval, int *depth, int
 void storeTTEntry(uint64_t key, int move, int value, int eval, int depth, int bound) {
 
     int i;
-    const uint16_t key16 = key >> 48;
+    uint64_t words[TT_CLUSTER_NB];
     TT_Entry *entry = TT.clusters[key & TT.hashMask].entry;
-    TT_Entry *replace = entry;
+    int replace = 0;
 
-    // Find a matching key16, or replace using MAX(x1, x2, x3),
+    // Decode the key signature, depth and generation of each entry
+    for (i = 0; i < TT_CLUSTER_NB; i++)
+        words[i] = loadTTWord(&entry[i].key) ^ loadTTWord(&entry[i].data);
+
+    // Find a matching key, or replace using MAX(x1, x2),
     // where xN equals the depth minus 4 times the age difference
-    for (i = 0; i < TT_CLUSTER_NB && entry[i].key16 != key16; i++)
-        if (   replace->depth - ((259 + TT.generation - replace->generation) & TT_MASK_AGE)
-            >= entry[i].depth - ((259 + TT.generation - entry[i].generation) & TT_MASK_AGE))
-            replace = &entry[i];
+    for (i = 0; i < TT_CLUSTER_NB && ((words[i] ^ key) & TT_MASK_KEY); i++)
+        if (   (int8_t)(words[replace] >> 8) - ((259 + TT.generation - (uint8_t)words[replace]) & TT_MASK_AGE)
+            >= (int8_t)(words[i]       >> 8) - ((259 + TT.generation - (uint8_t)words[i]      ) & TT_MASK_AGE))
+            replace = i;
 
     // Prefer a matching keys, otherwise score a replacement
-    replace = (i != TT_CLUSTER_NB) ? &entry[i] : replace;
+    replace = (i != TT_CLUSTER_NB) ? i : replace;
 
     // Don't overwrite an entry from the same position, unless we have
     // an exact bound or depth that is nearly as good as the old one
     if (   bound != BOUND_EXACT
-        && key16 == replace->key16
-        && depth < replace->depth - 3)
+        && !((words[replace] ^ key) & TT_MASK_KEY)
+        && depth < (int8_t)(words[replace] >> 8) - 3)
         return;
 
-    // Finally, copy the new data into the replaced slot
-    replace->depth      = (int8_t)depth;
-    replace->generation = (uint8_t)bound | TT.generation;
-    replace->value      = (int16_t)value;
-    replace->eval       = (int16_t)eval;
-    replace->key16      = (uint16_t)key16;
-    replace->move       = (int)move;
+    // Finally, pack the new data and write both words of the slot
+    uint64_t data = packTTData(move, value, eval);
+    uint64_t word = (key & TT_MASK_KEY) | (uint64_t)(uint8_t)depth << 8 | (uint8_t)bound | TT.generation;
+
+    storeTTWord(&entry[replace].data, data);
+    storeTTWord(&entry[replace].key, word ^ data);
 }
 
 int valueFromTT(int value, int ply) {
 
-    // When probing MATE scores into the table
-    // we must factor in the search ply
+    // When probing MATE and tablebase scores into
+    // the table we must factor in the search ply
 
-    return value >=  MATE_IN_MAX ? value - ply
-         : value <= MATED_IN_MAX ? value + ply : value;
+    return value >= VALUE_TB_WIN_IN_MAX  ? value - ply
+         : value <= VALUE_TB_LOSS_IN_MAX ? value + ply : value;
 }
 
 int valueToTT(int value, int ply) {
 
-    // When storing MATE scores into the table
-    // we must factor in the search ply
+    // When storing MATE and tablebase scores into
+    // the table we must factor in the search ply
 
-    return value >=  MATE_IN_MAX ? value + ply
-         : value <= MATED_IN_MAX ? value - ply : value;
+    return value >= VALUE_TB_WIN_IN_MAX  ? value + ply
+         : value <= VALUE_TB_LOSS_IN_MAX ? value - ply : value;
 }
\ No newline at end of file
@@ -32,20 +32,19 @@ enum {
 enum {
     TT_MASK_BOUND = 0x03,
     TT_MASK_AGE   = 0xFC,
-    TT_CLUSTER_NB = 3,
+    TT_CLUSTER_NB = 2,
 };
 
+static const uint64_t TT_MASK_KEY = ~0xFFFFull;
+static const uint64_t TT_HUGE_PAGE_SIZE = 1ull << 21;
+
 struct TT_Entry {
-    int8_t depth;
-    uint8_t generation;
-    int16_t eval, value;
-    uint16_t key16;
-    int move;
+    uint64_t key;  // Key bits, depth and generation, XOR'ed with data
+    uint64_t data; // Move (25 bits), value and eval (16 bits each)
 };
 
 struct TT_Cluster {
     TT_Entry entry[TT_CLUSTER_NB];
-    uint16_t padding;
 };
 
 struct TTable {
@@ -54,8 +53,9 @@ struct TTable {
     uint8_t generation;
 };
 
-void clearTTable();
-void initTTable(uint64_t MB);
+void* allocHugePages(uint64_t size);
+void clearTTable(int nthreads);
+void initTTable(uint64_t MB, int nthreads);
 void prefetchTTable(uint64_t key);
 int hashSizeTTable();
 void updateTTable();
@@ -19,11 +19,18 @@
 // uci.c
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "board.h"
 #include "defs.h"
 #include "endgame.h"
@@ -32,9 +39,13 @@
 #include "io.h"
 #include "makemove.h"
 #include "movegen.h"
+#include "pawns.h"
+#include "perft.h"
 #include "polybook.h"
 #include "search.h"
+#include "syzygy.h"
 #include "texel.h"
+#include "thread.h"
 #include "time.h"
 #include "ttable.h"
 #include "uci.h"
@@ -44,17 +55,26 @@ EngineOptions Options; // Our global engine options
 
 int main(int argc, char **argv) {
 
-	Board pos       = {0};
-    SearchInfo info = {0};
-    info.quit = 0;
+	static Undo history[MAXGAMEMOVES];
+	Board pos = { .history = history };
 
     // Set default options
     Options.PolyBook        = 0;
+    Options.BookDepth       = MAX_BOOK_DEPTH;
+    Options.BookMinWeight   = 0;
+    Options.BookBestMove    = 0;
+    Options.PawnHash        = PAWN_HASH_MB;
+    Options.MultiPV         = 1;
     Options.MinThinkingTime = 20;
     Options.MoveOverHead    = 30;
     Options.SlowMover       = 84;
 
+    Thread *threads = createThreadPool(1);
+
     char str[8192];
+    int searching = 0;
+    pthread_t pthreadsgo;
+    UCIGoStruct uciGoStruct = {0};
 
     // Initialize components of PayFleens
     AllInit(); endgameInit(&pos); ParseFen(StartPosition, &pos);
@@ -62,34 +82,68 @@ int main(int argc, char **argv) {
 
     handleCommandLine(argc, argv);
 
+    // The search runs in its own thread, while this one keeps reading
+    // the input. Only isready, stop and ponderhit are handled during a
+    // search, the other commands wait until the search has finished
+
     while (getInput(str)) {
 
+        if (   searching
+            && !strEquals(str, "isready")
+            && !strEquals(str, "stop")
+            && !strEquals(str, "ponderhit")
+            && !strEquals(str, "quit"))
+            pthread_join(pthreadsgo, NULL), searching = 0;
+
         if (strEquals(str, "uci")) {
 
 			printf("id name Payfleens %s\n", VERSION_ID);
 			printf("id author Roberto M. & Andrew Grant\n");
             printf("option name Hash type spin default 16 min 1 max 65536\n");
+            printf("option name Threads type spin default 1 min 1 max 2048\n");
+            printf("option name Pawn Hash type spin default %d min 1 max %d\n", PAWN_HASH_MB, PAWN_HASH_MAX);
             printf("option name Minimum Thinking Time type spin default 20 min 0 max 5000\n");
             printf("option name Move Overhead type spin default 30 min 0 max 5000\n");
             printf("option name Slow Mover type spin default 84 min 10 max 1000\n");
+            printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_MULTIPV);
+            printf("option name Ponder type check default false\n");
             printf("option name PolyBook type check default false\n");
+            printf("option name BookFile type string default <empty>\n");
+            printf("option name BookLearnFile type string default <empty>\n");
+            printf("option name BookDepth type spin default %d min 0 max %d\n", MAX_BOOK_DEPTH, MAX_BOOK_DEPTH);
+            printf("option name BookMinWeight type spin default 0 min 0 max 65535\n");
+            printf("option name BookBestMove type check default false\n");
+            printf("option name SyzygyPath type string default <empty>\n");
             printf("uciok\n"), fflush(stdout);
         }
 
         else if (strEquals(str, "isready"))
             printf("readyok\n"), fflush(stdout);
 
+        else if (strEquals(str, "stop"))
+            stopThreadPool(threads);
+
+        else if (strEquals(str, "ponderhit"))
+            uciPonderHit(&uciGoStruct);
+
         else if (strEquals(str, "ucinewgame"))
-            clearTTable();
+            clearTTable(threads->nthreads), initTimeManager(&threads->tm), WriteBookLearn();
 
         else if (strStartsWith(str, "setoption"))
-            uciSetOption(str);
+            uciSetOption(str, &threads);
 
         else if (strStartsWith(str, "position"))
         	uciPosition(str, &pos);
 
-        else if (strStartsWith(str, "go"))
-            uciGo(str, &info, &pos);
+        // USAGE: go perft <depth>, split over the configured Threads
+        else if (strStartsWith(str, "go perft"))
+            perftDivide(&pos, MAX(1, atoi(str + strlen("go perft"))), threads->nthreads);
+
+        else if (strStartsWith(str, "go")) {
+            uciGo(str, threads, &pos, &uciGoStruct);
+            pthread_create(&pthreadsgo, NULL, &uciSearch, &uciGoStruct);
+            searching = 1;
+        }
 
         else if (strEquals(str, "quit"))
             break;
@@ -98,30 +152,52 @@ int main(int argc, char **argv) {
             PrintBoard(&pos), fflush(stdout);
 
         else if (strStartsWith(str, "eval"))
-            printEval(&pos), fflush(stdout);
+            printEval(&pos, threads), fflush(stdout);
 
         else if (strStartsWith(str, "stats"))
-            printStats(&info), fflush(stdout);
+            printStats(threads), fflush(stdout);
 
         else if (strStartsWith(str, "mirror"))
-            MirrorEvalTest(&pos), fflush(stdout);
+            MirrorEvalTest(&pos, threads), fflush(stdout);
+
+        else if (strStartsWith(str, "ttstress"))
+            TTStressTest(MAX(1, atoi(str + strlen("ttstress")))), fflush(stdout);
+
+        else if (strEquals(str, "see"))
+            SEETest(), fflush(stdout);
+
+        else if (strStartsWith(str, "movefuzz"))
+            MoveFuzzTest(atoi(str + strlen("movefuzz"))), fflush(stdout);
+    }
+
+    // Abort a search still running on quit, or at the end of the input
+    if (searching) {
+        stopThreadPool(threads);
+        pthread_join(pthreadsgo, NULL);
     }
 
+    deleteThreadPool(threads);
+    WriteBookLearn(), CleanPolyBook();
+
     return 0;
 }
 
-void uciGo(char *str, SearchInfo *info, Board *pos) {
+void uciGo(char *str, Thread *threads, Board *pos, UCIGoStruct *uciGoStruct) {
 
     // Get our starting time as soon as possible
     double start = getTimeMs();
 
-    Limits limits = {0};
+    // The go command is parsed here, in the UCI thread, so that a stop
+    // or ponderhit which follows it can never race the search setup
+
+    Limits *const limits = &uciGoStruct->limits;
 
-    int bestMove = NONE_MOVE;
-    int depth = 0, infinite = 0, mtg = 0;
+    int depth = 0, infinite = 0, ponder = 0, mtg = 0, searchmoves = 0, move;
     double wtime = 0, btime = 0, movetime = 0;
     double winc = 0, binc = 0;
 
+    memset(limits, 0, sizeof(Limits));
+
     // Init the tokenizer with spaces
     char* ptr = strtok(str, " ");
 
@@ -135,46 +211,112 @@ void uciGo(char *str, SearchInfo *info, Board *pos) {
         if (strEquals(ptr, "depth")) depth = atoi(strtok(NULL, " "));
         if (strEquals(ptr, "movetime")) movetime = atoi(strtok(NULL, " "));
         if (strEquals(ptr, "infinite")) infinite = 1;
+        if (strEquals(ptr, "ponder")) ponder = 1;
+
+        // Every move that follows searchmoves restricts the root, until
+        // the next token which does not read as a legal move
+        if (strEquals(ptr, "searchmoves")) { searchmoves = 1; continue; }
+        if (searchmoves && strlen(ptr) >= 4 && (move = ParseMove(ptr, pos)) != NONE_MOVE)
+            limits->searchMoves[limits->searchMovesCount++] = move;
+        else searchmoves = 0;
     }
 
     // Initialize limits for the search
-    limits.limitedByNone  = infinite != 0;
-    limits.limitedByTime  = movetime != 0;
-    limits.limitedByDepth = depth    != 0;
-    limits.limitedBySelf  = !depth && !movetime && !infinite;
-    limits.timeLimit      = movetime;
-    limits.depthLimit     = depth;
+    limits->limitedByNone  = infinite != 0;
+    limits->limitedByTime  = movetime != 0;
+    limits->limitedByDepth = depth    != 0;
+    limits->limitedBySelf  = !depth && !movetime && !infinite;
+    limits->timeLimit      = movetime;
+    limits->depthLimit     = depth;
 
-    info->timeset = (limits.limitedBySelf || limits.limitedByTime) ? 1 : 0;
+    threads->info.timeset = (limits->limitedBySelf || limits->limitedByTime) ? 1 : 0;
 
     // Pick the time values for the colour we are playing as
-    limits.start = (pos->side == WHITE) ? start : start;
-    limits.time  = (pos->side == WHITE) ? wtime : btime;
-    limits.inc   = (pos->side == WHITE) ?  winc :  binc;
-    limits.mtg   = (pos->side == WHITE) ?   mtg :   mtg;
+    limits->start = (pos->side == WHITE) ? start : start;
+    limits->time  = (pos->side == WHITE) ? wtime : btime;
+    limits->inc   = (pos->side == WHITE) ?  winc :  binc;
+    limits->mtg   = (pos->side == WHITE) ?   mtg :   mtg;
+
+    uciGoStruct->threads = threads;
+    uciGoStruct->pos     = pos;
+
+    // Start from a clean stop signal, and while pondering the
+    // clock is not ours, until the interface sends a ponderhit
+    clearStopThreadPool(threads);
+    threads->info.pondering = ponder;
+    threads->info.ponderhit = 0;
+}
+
+void* uciSearch(void *vuciGoStruct) {
+
+    UCIGoStruct *const uciGoStruct = (UCIGoStruct*) vuciGoStruct;
+
+    int bestMove = NONE_MOVE, ponderMove = NONE_MOVE;
 
     // Execute search, return best and ponder moves
-    getBestMove(info, pos, &limits, &bestMove);
+    getBestMove(uciGoStruct->threads, uciGoStruct->pos, &uciGoStruct->limits, &bestMove, &ponderMove);
 
-    // Report best move ( we should always have one )
-    printf("bestmove %s", PrMove(bestMove));
+    // Report best move, or the null move when mated or stalemated
+    printf("bestmove %s", bestMove != NONE_MOVE ? PrMove(bestMove) : "0000");
+
+    // Report the expected reply, for the interface to ponder on
+    if (ponderMove != NONE_MOVE) printf(" ponder %s", PrMove(ponderMove));
 
     // Make sure this all gets reported
     printf("\n"); fflush(stdout);
+
+    return NULL;
+}
+
+void uciPonderHit(UCIGoStruct *uciGoStruct) {
+
+    SearchInfo *const info = &uciGoStruct->threads->info;
+
+    if (!info->pondering)
+        return;
+
+    // The opponent played the move we were pondering on, so our clock
+    // is running from now on. The main thread of the search restarts its
+    // time budget from there, see CheckPonderHit(), while the search and
+    // whatever it has found carries on. The reported time and nps still
+    // count from the go command
+    info->ponderhit = 1;
 }
 
-void uciSetOption(char *str) {
+void uciSetOption(char *str, Thread **threads) {
 
     // Handle setting UCI options in PayFleens. Options include:
     //  Hash                  : Size of the Transposition Table in Megabyes
+    //  Threads               : Number of search threads to use
+    //  Pawn Hash             : Size of each Thread's Pawn Hash Table in Megabytes
     //  Minimum Thinking Time : Think for at least this ms per move
     //  Move OverHead         : Overhead on time allocation to avoid time losses
+    //  MultiPV               : Number of best lines to search and report
     //  PolyBook              : Precalculated opening moves
+    //  BookFile              : Path of the Polyglot book used by PolyBook
+    //  BookLearnFile         : Local copy of the book which learns from our games
+    //  BookDepth             : Leave the book after this many plies of the game
+    //  BookMinWeight         : Ignore book moves with a lower weight
+    //  BookBestMove          : Always play the heaviest book move
     //  Slow Mover            : Lower values will make PayFleens think less time
+    //  SyzygyPath            : Directories of the Syzygy tablebases
 
     if (strStartsWith(str, "setoption name Hash value ")) {
         int MB = atoi(str + strlen("setoption name Hash value "));
-        initTTable(MB); printf("info string set Hash to %dMB\n", hashSizeTTable());
+        initTTable(MB, (*threads)->nthreads); printf("info string set Hash to %dMB\n", hashSizeTTable());
+    }
+
+    if (strStartsWith(str, "setoption name Threads value ")) {
+        int nthreads = MAX(1, atoi(str + strlen("setoption name Threads value ")));
+        deleteThreadPool(*threads); *threads = createThreadPool(nthreads);
+        printf("info string set Threads to %d\n", nthreads);
+    }
+
+    if (strStartsWith(str, "setoption name Pawn Hash value ")) {
+        int MB = atoi(str + strlen("setoption name Pawn Hash value "));
+        Options.PawnHash = MAX(1, MIN(MB, PAWN_HASH_MAX));
+        resizePawnTables(*threads, Options.PawnHash);
+        printf("info string set Pawn Hash to %dMB\n", Options.PawnHash);
     }
 
     if (strStartsWith(str, "setoption name Minimum Thinking Time value ")) {
@@ -195,10 +337,50 @@ void uciSetOption(char *str) {
         Options.SlowMover = slowMover;
     }
 
+    if (strStartsWith(str, "setoption name MultiPV value ")) {
+        int multiPV = atoi(str + strlen("setoption name MultiPV value "));
+        Options.MultiPV = MAX(1, MIN(multiPV, MAX_MULTIPV));
+        printf("info string set MultiPV to %d\n", Options.MultiPV);
+    }
+
+    if (strStartsWith(str, "setoption name SyzygyPath value ")) {
+        char *path = str + strlen("setoption name SyzygyPath value ");
+        initSyzygy(strEquals(path, "<empty>") ? "" : path);
+    }
+
+    if (strStartsWith(str, "setoption name BookFile value ")) {
+        char *path = str + strlen("setoption name BookFile value ");
+        if (strEquals(path, "<empty>")) CleanPolyBook();
+        else InitPolyBook(path);
+    }
+
+    if (strStartsWith(str, "setoption name BookLearnFile value ")) {
+        char *path = str + strlen("setoption name BookLearnFile value ");
+        if (strEquals(path, "<empty>")) ClearBookLearnFile();
+        else SetBookLearnFile(path);
+    }
+
+    if (strStartsWith(str, "setoption name BookDepth value ")) {
+        int bookDepth = atoi(str + strlen("setoption name BookDepth value "));
+        Options.BookDepth = MAX(0, MIN(bookDepth, MAX_BOOK_DEPTH));
+        printf("info string set BookDepth to %d\n", Options.BookDepth);
+    }
+
+    if (strStartsWith(str, "setoption name BookMinWeight value ")) {
+        int minWeight = atoi(str + strlen("setoption name BookMinWeight value "));
+        Options.BookMinWeight = MAX(0, MIN(minWeight, 65535));
+        printf("info string set BookMinWeight to %d\n", Options.BookMinWeight);
+    }
+
+    if (strStartsWith(str, "setoption name BookBestMove value ")) {
+        Options.BookBestMove = strStartsWith(str, "setoption name BookBestMove value true");
+        printf("info string set BookBestMove to %s\n", Options.BookBestMove ? "true" : "false");
+    }
+
     if (strStartsWith(str, "setoption name PolyBook value ")) {
         if (strStartsWith(str, "setoption name PolyBook value true")) {
             printf("info string set PolyBook to true\n"), Options.PolyBook = 1;
-            InitPolyBook();
+            if (!PolyBookLoaded()) printf("info string No book loaded, see BookFile\n");
         }
         if (strStartsWith(str, "setoption name PolyBook value false"))
             printf("info string set PolyBook to false\n"), Options.PolyBook = 0;
@@ -240,16 +422,21 @@ void uciPosition(char* str, Board *pos) {
     }
 }
 
-void uciReport(SearchInfo *info, Board *pos, int alpha, int beta, int value) {
+void uciReport(Thread *threads, PVariation *pv, int alpha, int beta, int value) {
 
     // Gather all of the statistics that the UCI protocol
-    // would be interested in.
+    // would be interested in. Nodes are summed over all threads,
+    // everything else is reported from the main thread.
 
+    SearchInfo *info = &threads->info;
+
+    int multiPV     = threads->multiPV + 1;
     int hashfull    = hashfullTTable();
     int depth       = info->depth;
     int seldepth    = info->seldepth;
-    int elapsed     = elapsedTime(info);
-    uint64_t nodes  = info->nodes;
+    int elapsed     = getTimeMs() - threads->limits->start;
+    uint64_t nodes  = nodesSearchedThreadPool(threads);
+    uint64_t tbhits = tbhitsThreadPool(threads);
     int nps         = (int)(1000 * (nodes / (1 + elapsed)));
 
     // If the score is MATE or MATED in X, convert to X,
@@ -264,13 +451,13 @@ void uciReport(SearchInfo *info, Board *pos, int alpha, int beta, int value) {
     char *bound = value >=  beta ? "lowerbound "
                 : value <= alpha ? "upperbound " : "";
 
-    printf("info depth %d seldepth %d score %s %d %stime %d "
-           "nodes %"PRIu64" nps %d hashfull %d pv ",
-           depth, seldepth, type, score, bound, elapsed, nodes, nps, hashfull);
+    printf("info depth %d seldepth %d multipv %d score %s %d %stime %d "
+           "nodes %"PRIu64" nps %d tbhits %"PRIu64" hashfull %d pv ",
+           depth, seldepth, multiPV, type, score, bound, elapsed, nodes, nps, tbhits, hashfull);
 
     // Iterate over the PV and print each move
-    for (int i = 0; i < pos->pv.length; i++)
-        printf("%s ",PrMove(pos->pv.line[i]));
+    for (int i = 0; i < pv->length; i++)
+        printf("%s ",PrMove(pv->line[i]));
 
     // Send out a newline and flush
     puts(""); fflush(stdout);
@@ -282,24 +469,44 @@ void uciReportCurrentMove(int move, int currmove, int depth) {
     fflush(stdout);
 }
 
-void printStats(SearchInfo *info) {
+void printStats(Thread *threads) {
+
+    SearchInfo *info = &threads->info;
+    uint64_t probes = 0ull, hits = 0ull;
+
+    for (int i = 0; i < threads->nthreads; i++) {
+        probes += threads[i].pawnTable.probes;
+        hits   += threads[i].pawnTable.hits;
+    }
+
     printf("TTCut:%d Ordering:%.2f NullCut:%d\n",info->TTCut,(info->fhf/info->fh)*100,info->nullCut);
+    printf("PawnHash:%.2f%%\n", probes ? 100.0 * hits / probes : 0.0);
 }
 
 void handleCommandLine(int argc, char **argv) {
 
-    // USAGE: ./Payfleens bench <depth> <hash>
+    // USAGE: ./Payfleens bench <depth> <hash> <threads>
     if (argc > 1 && strEquals(argv[1], "bench")) {
         runBenchmark(argc, argv);
         exit(EXIT_SUCCESS);
     }
 
-    // USAGE: ./Payfleens evalbook <book> <depth> <hash>
+    // USAGE: ./Payfleens perft <depth> <threads> <hash> <epd>
+    if (argc > 1 && strEquals(argv[1], "perft"))
+        exit(runPerftSuite(argc, argv) ? EXIT_FAILURE : EXIT_SUCCESS);
+
+    // USAGE: ./Payfleens evalbook <book> <newbook> <positions> <depth> <hash> <workers>
     if (argc > 1 && strEquals(argv[1], "evalbook")) {
         runEvalBook(argc, argv);
         exit(EXIT_SUCCESS);
     }
 
+    // USAGE: ./Payfleens pack <epd> <packed>
+    if (argc > 3 && strEquals(argv[1], "pack")) {
+        runPackBook(argc, argv);
+        exit(EXIT_SUCCESS);
+    }
+
     // Tuner is being run from the command line
     #ifdef TUNE
         runTexelTuning();
@@ -307,6 +514,28 @@ void handleCommandLine(int argc, char **argv) {
     #endif
 }
 
+static void benchmarkSuite(char **Benchmarks, Thread *threads, Limits *limits, int *scores,
+                           double *times, uint64_t *nodes, int *bestMoves, int *depths) {
+
+    Board pos = {0};
+    int ponderMove;
+
+    for (int i = 0; strcmp(Benchmarks[i], ""); i++) {
+
+        // Perform the search on the position
+        limits->start = getTimeMs();
+        ParseFen(Benchmarks[i], &pos);
+        clearStopThreadPool(threads);
+        getBestMove(threads, &pos, limits, &bestMoves[i], &ponderMove);
+
+        // Stat collection for later printing
+        scores[i] = threads->info.values[limits->depthLimit];
+        times[i] = getTimeMs() - limits->start;
+        nodes[i] = nodesSearchedThreadPool(threads);
+        depths[i] = threads->completedDepth;
+    }
+}
+
 void runBenchmark(int argc, char **argv) {
 
     char *Benchmarks[] = {
@@ -314,41 +543,46 @@ void runBenchmark(int argc, char **argv) {
         ""
     };
 
-    Board pos       = {0};
-    SearchInfo info = {0};
+    Thread *threads = NULL;
     Limits limits   = {0};
 
-    int scores[256];
-    double times[256];
-    uint64_t nodes[256];
-    int bestMoves[256];
+    int scores[256], depths[256];
+    double times[256], baseTimes[256];
+    uint64_t nodes[256], baseNodes[256];
+    int bestMoves[256], baseMoves[256];
 
-    double time;
-    uint64_t totalNodes = 0ull;
+    double time, baseTime = 0;
+    uint64_t totalNodes = 0ull, totalBaseNodes = 0ull;
 
     int depth     = argc > 2 ? atoi(argv[2]) : 13;
     int megabytes = argc > 3 ? atoi(argv[3]) : 16;
+    int nthreads  = argc > 4 ? MAX(1, atoi(argv[4])) : 1;
 
-    initTTable(megabytes);
-    time = getTimeMs();
+    initTTable(megabytes, nthreads);
 
     // Initialize a "go depth <x>" search
     limits.limitedByDepth = 1;
     limits.depthLimit = depth;
 
-    for (int i = 0; strcmp(Benchmarks[i], ""); i++) {
+    // With more than one thread, first run the suite on a single
+    // thread, to have a baseline for the time-to-depth speedup
+    if (nthreads > 1) {
 
-        // Perform the search on the position
-        limits.start = getTimeMs();
-        ParseFen(Benchmarks[i], &pos);
-        getBestMove(&info, &pos, &limits, &bestMoves[i]);
+        threads  = createThreadPool(1);
+        baseTime = getTimeMs();
+        benchmarkSuite(Benchmarks, threads, &limits, scores, baseTimes, baseNodes, baseMoves, depths);
+        baseTime = getTimeMs() - baseTime;
+        deleteThreadPool(threads);
 
-        // Stat collection for later printing
-        scores[i] = info.values[depth];
-        times[i] = getTimeMs() - limits.start;
-        nodes[i] = info.nodes;
+        clearTTable(nthreads);
     }
 
+    threads = createThreadPool(nthreads);
+    time = getTimeMs();
+    benchmarkSuite(Benchmarks, threads, &limits, scores, times, nodes, bestMoves, depths);
+    time = getTimeMs() - time;
+    deleteThreadPool(threads);
+
     printf("\n=================================================================================\n");
 
     for (int i = 0; strcmp(Benchmarks[i], ""); i++) {
@@ -361,53 +595,327 @@ void runBenchmark(int argc, char **argv) {
     printf("=================================================================================\n");
 
     // Report the overall statistics
-    time = getTimeMs() - time;
     for (int i = 0; strcmp(Benchmarks[i], ""); i++) totalNodes += nodes[i];
     printf("OVERALL: %53d nodes %8d nps\n", (int)totalNodes, (int)(1000.0f * totalNodes / (time + 1)));
+
+    if (nthreads > 1) {
+
+        // Report the combined speed of all threads, and how much faster
+        // than a single thread the same depths have been reached
+        for (int i = 0; strcmp(Benchmarks[i], ""); i++) totalBaseNodes += baseNodes[i];
+        printf("1 THREAD: %52d nodes %8d nps %8dms\n", (int)totalBaseNodes,
+            (int)(1000.0f * totalBaseNodes / (baseTime + 1)), (int)baseTime);
+        printf("%2d THREADS: %50d nodes %8d nps %8dms\n", nthreads, (int)totalNodes,
+            (int)(1000.0f * totalNodes / (time + 1)), (int)time);
+        printf("NPS SCALING: %.2fx  TIME-TO-DEPTH SPEEDUP: %.2fx\n",
+            (totalNodes / (time + 1)) / (totalBaseNodes / (baseTime + 1)), (baseTime + 1) / (time + 1));
+    }
 }
 
-void runEvalBook(int argc, char **argv) {
+enum { EVALBOOK_PENDING = VALUE_NONE + 1, EVALBOOK_SKIPPED = VALUE_NONE + 2 };
 
-    printf("STARTING EVALBOOK\n");
+typedef struct EvalBookQueue {
+    char *path;
+    long *offsets;
+    int isPacked, count, depth, megabytes;
+    int *next, *values; // Shared by every worker and the writer
+} EvalBookQueue;
 
+static int readEvalBookEntry(FILE *book, int isPacked, char *line, PackedBoard *packed, Board *pos) {
+
+    if (isPacked ? fread(packed, sizeof(PackedBoard), 1, book) != 1
+                 : fgets(line, 256, book) == NULL)
+        return 0;
+
+    // Without a board, only the raw entry is wanted
+    if (pos != NULL && isPacked) unpackBoard(packed, pos);
+    else if (pos != NULL) ParseFen(line, pos);
+
+    return 1;
+}
+
+static void* evalBookWorker(void *vqueue) {
+
+    EvalBookQueue *const queue = (EvalBookQueue*) vqueue;
+
+    // Every worker is a complete search context of its own, with its own
+    // Transposition Table, and takes the next position of the shared queue
     Board pos       = {0};
-    SearchInfo info = {0};
+    Thread *threads = createThreadPool(1);
     Limits limits   = {0};
+    PackedBoard packed;
     char line[256];
-    int i, best;
-    double start = getTimeMs();
+    int i, best, ponder, value;
 
-    FILE *book    = fopen(argv[2], "r");
-    FILE *newbook = fopen(argv[3], "w");
-    int positions = argc > 4 ? atoi(argv[4]) : 100000;
-    int depth     = argc > 5 ? atoi(argv[5]) : 12;
-    int megabytes = argc > 6 ? atoi(argv[6]) :  1;
+    FILE *book = fopen(queue->path, queue->isPacked ? "rb" : "r");
 
     limits.limitedByDepth = 1;
-    limits.depthLimit = depth;
-    initTTable(megabytes);
+    limits.depthLimit = queue->depth;
+    initTTable(queue->megabytes, 1);
+
+    while ((i = __atomic_fetch_add(queue->next, 1, __ATOMIC_RELAXED)) < queue->count) {
+
+        limits.start = getTimeMs();
+        fseek(book, queue->offsets[i], SEEK_SET);
+        readEvalBookEntry(book, queue->isPacked, line, &packed, &pos);
+
+        if (!LegalMoveExist(&pos))
+            value = EVALBOOK_SKIPPED;
+
+        else {
+            clearStopThreadPool(threads);
+            getBestMove(threads, &pos, &limits, &best, &ponder);
+            clearTTable(1);
+            value = threads->info.values[queue->depth];
+        }
+
+        __atomic_store_n(&queue->values[i], value, __ATOMIC_RELEASE);
+    }
 
+    fclose(book);
+    deleteThreadPool(threads);
+
+    return NULL;
+}
+
+static void writeEvalBookCheckpoint(char *path, int index, long offset) {
+
+    FILE *fout = fopen(path, "w");
+
+    if (fout != NULL)
+        fprintf(fout, "%d %ld\n", index, offset), fclose(fout);
+}
+
+void runEvalBook(int argc, char **argv) {
+
+    printf("STARTING EVALBOOK\n");
+
+    EvalBookQueue queue = {0};
+    PackedBoard packed;
+    char line[256], checkpoint[1024];
+    int i, value, start = 0;
+    long offset = 0;
+    double startTime = getTimeMs(), lastCheckpoint = startTime;
+
+    // Books of packed positions are labelled into packed books
+    queue.path      = argv[2];
+    queue.isPacked  = strEndsWith(argv[2], ".packed");
+    int positions   = argc > 4 ? atoi(argv[4]) : 100000;
+    queue.depth     = argc > 5 ? atoi(argv[5]) : 12;
+    queue.megabytes = argc > 6 ? atoi(argv[6]) :  1;
+    int workers     = argc > 7 ? MAX(1, atoi(argv[7])) : 1;
+
+    FILE *book = fopen(argv[2], queue.isPacked ? "rb" : "r");
+
+    if (book == NULL) {
+        printf("Unable to open %s\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+
+    // Find where each position starts, so that the workers may seek to them
+    queue.offsets = malloc(sizeof(long) * MAX(1, positions));
     for (i = 0; i < positions; i++) {
+        queue.offsets[i] = ftell(book);
+        if (!readEvalBookEntry(book, queue.isPacked, line, &packed, NULL))
+            break;
+    }
+    queue.count = i;
+
+    // A checkpoint of an interrupted run tells us how far its output is
+    // complete, and the output is cut back to there before resuming
+    snprintf(checkpoint, sizeof(checkpoint), "%s.ckpt", argv[3]);
+    FILE *fckpt = fopen(checkpoint, "r");
+    if (fckpt != NULL) {
+        if (fscanf(fckpt, "%d %ld", &start, &offset) != 2)
+            start = 0, offset = 0;
+        fclose(fckpt);
+    }
+
+    FILE *newbook = fopen(argv[3], start ? (queue.isPacked ? "r+b" : "r+") : (queue.isPacked ? "wb" : "w"));
 
-        // Read next position from the FEN file
-        if (fgets(line, 256, book) == NULL) {
-            printf("Unable to read line #%d\n", i);
-            exit(EXIT_FAILURE);
+    if (newbook == NULL) {
+        printf("Unable to open %s\n", argv[3]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (start) {
+        printf("RESUMING FROM POSITION %d\n", start + 1);
+        fseek(newbook, offset, SEEK_SET);
+    }
+
+    // The queue and the results live in memory shared with every worker
+    queue.next   = calloc(1, sizeof(int));
+    queue.values = malloc(sizeof(int) * MAX(1, queue.count));
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    // Without fork(), a single worker searches in a thread of our own,
+    // as the Transposition Table can not be split between threads
+    pthread_t worker;
+
+    printf("WORKERS ARE NOT SUPPORTED ON WINDOWS, USING ONE\n"), (void) workers;
+    for (i = 0; i < queue.count; i++) queue.values[i] = EVALBOOK_PENDING;
+    *queue.next = start;
+    pthread_create(&worker, NULL, &evalBookWorker, &queue);
+
+#else
+
+    // Rows past the checkpoint may be incomplete, and must not survive
+    if (start && ftruncate(fileno(newbook), offset) != 0) {
+        printf("Unable to truncate %s to the checkpoint\n", argv[3]);
+        exit(EXIT_FAILURE);
+    }
+
+    free(queue.next), free(queue.values);
+    queue.next   = mmap(NULL, sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    queue.values = mmap(NULL, sizeof(int) * MAX(1, queue.count), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (queue.next == MAP_FAILED || queue.values == MAP_FAILED) {
+        printf("Unable to map the memory shared with the workers\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < queue.count; i++) queue.values[i] = EVALBOOK_PENDING;
+    *queue.next = start;
+
+    // Each worker is a process of its own, so nothing but the queue and the
+    // results is shared. Output buffers are flushed to not be written twice
+    fflush(stdout), fflush(newbook);
+    for (i = 0; i < workers; i++)
+        if (fork() == 0)
+            evalBookWorker(&queue), _exit(EXIT_SUCCESS);
+
+#endif
+
+    // Write the results in the order of the book as they arrive, keeping
+    // the checkpoint up to date with what has been fully written so far
+    fseek(book, queue.count > start ? queue.offsets[start] : ftell(book), SEEK_SET);
+
+    for (i = start; i < queue.count; i++) {
+
+        while ((value = __atomic_load_n(&queue.values[i], __ATOMIC_ACQUIRE)) == EVALBOOK_PENDING) {
+
+#if !defined(_WIN32) && !defined(_WIN64)
+            // Workers only exit once the queue is empty, so when all of them
+            // are gone with results still missing, they must have crashed
+            while (waitpid(-1, NULL, WNOHANG) > 0) workers--;
+            if (workers == 0 && __atomic_load_n(&queue.values[i], __ATOMIC_ACQUIRE) == EVALBOOK_PENDING) {
+                printf("\nWorkers exited before position #%d, resume from the checkpoint\n", i + 1);
+                fflush(newbook), writeEvalBookCheckpoint(checkpoint, i, ftell(newbook));
+                exit(EXIT_FAILURE);
+            }
+#endif
+            usleep(1000);
         }
 
-        ParseFen(line, &pos);
+        readEvalBookEntry(book, queue.isPacked, line, &packed, NULL);
 
-        if (!LegalMoveExist(&pos))
+        printf("\rINITIALIZING SCORES FROM FENS...  [%7d OF %7d]", i + 1, queue.count);
+
+        if (value != EVALBOOK_SKIPPED) {
+            if (queue.isPacked) {
+                packed.eval = value;
+                fwrite(&packed, sizeof(PackedBoard), 1, newbook);
+            } else
+                fprintf(newbook, "FEN [#   %6d] %5d %s", i+1, value, line);
+        }
+
+        if (getTimeMs() - lastCheckpoint > 1000) {
+            fflush(newbook), lastCheckpoint = getTimeMs();
+            writeEvalBookCheckpoint(checkpoint, i + 1, ftell(newbook));
+        }
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    pthread_join(worker, NULL);
+    free(queue.next), free(queue.values);
+#else
+    while (wait(NULL) > 0);
+    munmap(queue.next, sizeof(int));
+    munmap(queue.values, sizeof(int) * MAX(1, queue.count));
+#endif
+
+    fclose(book), fclose(newbook);
+    free(queue.offsets);
+    remove(checkpoint);
+
+    printf("Time %dms\n", (int)(getTimeMs() - startTime));
+}
+
+static int readPackBookLine(FILE *fin, Board *pos, PackedBoard *packed) {
+
+    char line[256], *fen;
+    int eval;
+
+    while (fgets(line, 256, fin) != NULL) {
+
+        // Lines of evalbook output carry their score before the FEN
+        fen = line, eval = 0;
+        if (strStartsWith(line, "FEN [#"))
+            eval = strtol(strstr(line, "] ") + 2, &fen, 10), fen++;
+
+        if (ParseFen(fen, pos))
             continue;
 
-        getBestMove(&info, &pos, &limits, &best);
-        clearTTable();
+        packBoard(pos, packed);
+        packed->eval   = eval;
+        packed->result = strstr(line, "\"1-0\"")     ? 2
+                       : strstr(line, "\"1/2-1/2\"") ? 1
+                       : strstr(line, "\"0-1\"")     ? 0 : PACKED_NO_RESULT;
+        return 1;
+    }
+
+    return 0;
+}
 
-        printf("\rINITIALIZING SCORES FROM FENS...  [%7d OF %7d]", i + 1, positions);
-        fprintf(newbook, "FEN [#   %6d] %5d %s", i+1, info.values[depth], line);
+void runPackBook(int argc, char **argv) {
+
+    (void) argc;
+
+    Board pos = {0}, unpacked = {0};
+    PackedBoard packed, stored;
+    int count = 0, errors = 0;
+    double fenTime, packedTime;
+
+    FILE *fin  = fopen(argv[2], "r");
+    FILE *fout = fopen(argv[3], "wb");
+
+    if (fin == NULL || fout == NULL) {
+        printf("Unable to open %s or %s\n", argv[2], argv[3]);
+        exit(EXIT_FAILURE);
     }
 
-    printf("Time %dms\n", (int)(getTimeMs() - start));
+    // Convert the FEN file, timing it as the load of a FEN book
+    fenTime = getTimeMs();
+    for (; readPackBookLine(fin, &pos, &packed); count++)
+        fwrite(&packed, sizeof(PackedBoard), 1, fout);
+    fenTime = getTimeMs() - fenTime;
+    fclose(fout);
+
+    // Time loading the same positions back from the packed file
+    fout = fopen(argv[3], "rb");
+    packedTime = getTimeMs();
+    while (fread(&stored, sizeof(PackedBoard), 1, fout) == 1)
+        unpackBoard(&stored, &unpacked);
+    packedTime = getTimeMs() - packedTime;
+
+    // Check that every position comes back as it was parsed
+    rewind(fin), rewind(fout);
+    while (   readPackBookLine(fin, &pos, &packed)
+           && fread(&stored, sizeof(PackedBoard), 1, fout) == 1) {
+        unpackBoard(&stored, &unpacked);
+        errors +=  unpacked.posKey      != pos.posKey
+                || unpacked.pawnKey     != pos.pawnKey
+                || unpacked.materialKey != pos.materialKey
+                || unpacked.gamePly     != pos.gamePly
+                || unpacked.fiftyMove   != pos.fiftyMove;
+    }
+
+    fclose(fin), fclose(fout);
+
+    printf("Packed %d positions into %s, %d mismatched\n", count, argv[3], errors);
+    printf("FEN load    %8.1f ms per million positions\n", 1e6 * fenTime    / MAX(1, count));
+    printf("Packed load %8.1f ms per million positions\n", 1e6 * packedTime / MAX(1, count));
 }
 
 int getInput(char *str) {
@@ -434,6 +942,11 @@ int strStartsWith(char *str, char *key) {
     return strstr(str, key) == str;
 }
 
+int strEndsWith(char *str, char *key) {
+    size_t length = strlen(str), keyLength = strlen(key);
+    return length >= keyLength && strEquals(str + length - keyLength, key);
+}
+
 int strContains(char *str, char *key) {
     return strstr(str, key) != NULL;
 }
\ No newline at end of file
@@ -21,34 +21,46 @@
 #include "defs.h"
 
 #define StartPosition "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
-#define VERSION_ID "1.86" // Bench 9529876 9529876
+#define VERSION_ID "1.86" // Bench 8306600 8306600
 
 struct Limits {
     double start, time, inc, timeLimit;
     int limitedByNone, limitedByTime, limitedBySelf;
     int limitedByDepth, depthLimit, mtg;
+    int searchMoves[MAX_MOVES], searchMovesCount;
+};
+
+struct UCIGoStruct {
+    Thread *threads;
+    Board *pos;
+    Limits limits;
 };
 
 struct EngineOptions {
-	int PolyBook;
+	int PolyBook, BookDepth, BookMinWeight, BookBestMove;
+	int PawnHash, MultiPV;
 	double MinThinkingTime, MoveOverHead, SlowMover; 
 };
 
-void uciGo(char *str, SearchInfo *info, Board *pos);
-void uciSetOption(char *str);
+void uciGo(char *str, Thread *threads, Board *pos, UCIGoStruct *uciGoStruct);
+void* uciSearch(void *vuciGoStruct);
+void uciPonderHit(UCIGoStruct *uciGoStruct);
+void uciSetOption(char *str, Thread **threads);
 void uciPosition(char* str, Board *pos);
 
-void uciReport(SearchInfo *info, Board *pos, int alpha, int beta, int value);
+void uciReport(Thread *threads, PVariation *pv, int alpha, int beta, int value);
 void uciReportCurrentMove(int move, int currmove, int depth);
-void printStats(SearchInfo *info);
+void printStats(Thread *threads);
 
 void handleCommandLine(int argc, char **argv);
 void runBenchmark(int argc, char **argv);
 void runEvalBook(int argc, char **argv);
+void runPackBook(int argc, char **argv);
 
 int getInput(char *str);
 int strEquals(char *str1, char *str2);
 int strStartsWith(char *str, char *key);
+int strEndsWith(char *str, char *key);
 int strContains(char *str, char *key);
 
 extern EngineOptions Options;
\ No newline at end of file
@@ -18,9 +18,12 @@
 
 // validate.c
 
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "attack.h"
 #include "board.h"
 #include "defs.h"
 #include "endgame.h"
@@ -29,12 +32,12 @@
 #include "makemove.h"
 #include "movegen.h"
 #include "search.h"
+#include "thread.h"
 #include "time.h"
 #include "ttable.h"
+#include "uci.h"
 #include "validate.h"
 
-uint64_t leafNodes;
-
 #ifdef DEBUG
 
 int MoveListOk(const MoveList *list, const Board *pos) {
@@ -87,63 +90,9 @@ int PieceValid(const int pce) {
 	return (pce >= wP && pce <= bK);
 }
 
-void Perft(int depth, Board *pos) {
-
-    ASSERT(CheckBoard(pos));
-
-    if (depth == 0) {
-        leafNodes++;
-        return;
-    }   
-
-    MoveList list = {0};
-    GenerateAllMoves(pos, &list);
-
-    for (int MoveNum = 0; MoveNum < list.count; ++MoveNum) {   
-       
-        if (!MakeMove(pos, list.moves[MoveNum].move))
-            continue;
-
-        Perft(depth - 1, pos);
-        TakeMove(pos);
-    }
-
-    return;
-}
-
-
-void PerftTest(int depth, Board *pos) {
-
-    ASSERT(CheckBoard(pos));
-
-    PrintBoard(pos);
-    printf("\nStarting Test To Depth:%d\n",depth);  
-    leafNodes = 0;
-    int move;
-    
-    MoveList list = {0};
-    GenerateAllMoves(pos, &list);         
-
-    for (int MoveNum = 0; MoveNum < list.count; ++MoveNum) {
-        move = list.moves[MoveNum].move;
-        if (!MakeMove(pos, move))
-            continue;
-        
-        uint64_t cumnodes = leafNodes;
-        Perft(depth - 1, pos);
-        TakeMove(pos);        
-        uint64_t oldnodes = leafNodes - cumnodes;
-        printf("move %d : %s : %I64d\n",MoveNum+1, PrMove(move), oldnodes);
-    }
-    
-    printf("\nTest Complete : %I64d nodes visited\n",leafNodes);
-
-    return;
-}
-
 #endif
 
-void MirrorEvalTest(Board *pos) {
+void MirrorEvalTest(Board *pos, Thread *thread) {
     FILE *file;
     file = fopen("../perftsuite.epd","r");
     char lineIn[1024];
@@ -156,18 +105,18 @@ void MirrorEvalTest(Board *pos) {
         while(fgets(lineIn , 1024 ,file) != NULL) {
             ParseFen(lineIn, pos);
             positions++;
-            ev1 = EvalPosition(pos, &Table);
+            ev1 = EvalPosition(pos, thread);
             MirrorBoard(pos);
-            ev2 = EvalPosition(pos, &Table);
+            ev2 = EvalPosition(pos, thread);
 
             if (ev1 != ev2) {
                 printf("\n\n\n");
                 ParseFen(lineIn, pos);
                 PrintBoard(pos);
-                printEval(pos);
+                printEval(pos, thread);
                 MirrorBoard(pos);
                 PrintBoard(pos);
-                printEval(pos);
+                printEval(pos, thread);
                 printf("\n\nMirror Fail:\n%s\n",lineIn);
                 getchar();
                 return;
@@ -181,4 +130,247 @@ void MirrorEvalTest(Board *pos) {
     }
 
     printf("MirrorEvalTest() finished with succes!\n");
-}
\ No newline at end of file
+}
+
+typedef struct TTStressWorker {
+    uint64_t seed, probes, hits, corrupted;
+} TTStressWorker;
+
+static uint64_t stressKey(uint64_t index) {
+
+    // Spread the pool index over all 64 bits of a key
+    index = (index ^ (index >> 30)) * 0xBF58476D1CE4E5B9ull;
+    index = (index ^ (index >> 27)) * 0x94D049BB133111EBull;
+    return index ^ (index >> 31);
+}
+
+static void stressEntry(uint64_t key, int *move, int *value, int *eval, int *depth, int *bound) {
+
+    // Every field of an entry is a function of its key, so
+    // any entry returned by a probe can be fully verified
+    *move  = (key >> 16) & 0x1FFFFFF;
+    *value = (int16_t)(key >> 8);
+    *eval  = (int16_t)(key >> 44);
+    *depth = (key >> 36) % MAX_PLY;
+    *bound = 1 + (key >> 58) % 3;
+}
+
+static void* TTStressWorkerLoop(void *vworker) {
+
+    TTStressWorker *worker = (TTStressWorker*) vworker;
+    uint64_t seed = worker->seed;
+    int move, value, eval, depth, bound;
+    int ttMove, ttValue, ttEval, ttDepth, ttBound;
+
+    for (int i = 0; i < 1 << 22; i++) {
+
+        // Store a random key from a pool which is much larger than the
+        // table, so that slots are constantly overwritten by all threads
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        uint64_t key = stressKey((seed * 2685821657736338717ull) >> 44);
+
+        stressEntry(key, &move, &value, &eval, &depth, &bound);
+        storeTTEntry(key, move, value, eval, depth, bound);
+
+        // Probe another random key and verify all of its fields
+        seed ^= seed >> 12, seed ^= seed << 25, seed ^= seed >> 27;
+        key = stressKey((seed * 2685821657736338717ull) >> 44);
+
+        worker->probes++;
+
+        if (!probeTTEntry(key, &ttMove, &ttValue, &ttEval, &ttDepth, &ttBound))
+            continue;
+
+        stressEntry(key, &move, &value, &eval, &depth, &bound);
+
+        worker->hits++;
+        worker->corrupted += ttMove  != move  || ttValue != value
+                          || ttEval  != eval  || ttDepth != depth
+                          || ttBound != bound;
+    }
+
+    return NULL;
+}
+
+void TTStressTest(int nthreads) {
+
+    // Hammer a small Transposition Table from many threads at once
+    // and verify that no probe ever returns a torn or mixed entry.
+    // The table is cleared afterwards, as it is filled with garbage
+
+    pthread_t pthreads[nthreads];
+    TTStressWorker workers[nthreads];
+    uint64_t probes = 0, hits = 0, corrupted = 0;
+    int megabytes = hashSizeTTable();
+    double start = getTimeMs();
+
+    initTTable(1, 1);
+
+    for (int i = 0; i < nthreads; i++) {
+        workers[i] = (TTStressWorker) { 1070372ull * (i + 1), 0, 0, 0 };
+        pthread_create(&pthreads[i], NULL, &TTStressWorkerLoop, &workers[i]);
+    }
+
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(pthreads[i], NULL);
+        probes += workers[i].probes;
+        hits += workers[i].hits;
+        corrupted += workers[i].corrupted;
+    }
+
+    initTTable(megabytes, 1);
+
+    printf("TTStressTest() threads %d probes %"PRIu64" hits %"PRIu64" corrupted %"PRIu64" time %dms\n",
+        nthreads, probes, hits, corrupted, (int)(getTimeMs() - start));
+    printf("TTStressTest() finished with %s!\n", corrupted ? "failure" : "success");
+}
+
+void SEETest() {
+
+    // Check that see() finds the exact value of each exchange: it must
+    // accept the expected value as a threshold, and reject one above
+
+    static const struct { char *fen, *move; int value; } Tests[] = {
+        { "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100 },
+        { "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -350 },
+        { "4R3/2r3p1/5bk1/1p1r3p/p2PR1P1/P1BK1P2/1P6/8 b - - 0 1", "h5g4", 0 },
+        { "4R3/2r3p1/5bk1/1p1r1p1p/p2PR1P1/P1BK1P2/1P6/8 b - - 0 1", "h5g4", 0 },
+        { "4r1k1/5pp1/nbp4p/1p2p2q/1P2P1b1/1BP2N1P/1B2QPPK/3R4 b - - 0 1", "g4f3", 0 },
+        { "2r1r1k1/pp1bppbp/3p1np1/q3P3/2P2P2/1P2B3/P1N1B1PP/2RQ1RK1 b - - 0 1", "d6e5", 100 },
+        { "3q2k1/8/8/3r4/8/8/3R4/3Q2K1 w - - 0 1", "d2d5", 675 },
+        { "k7/8/8/3p4/4p3/5B2/6Q1/K7 w - - 0 1", "f3e4", -250 },
+        { "3rk3/8/8/8/8/8/3R4/3RK3 w - - 0 1", "d2d8", 675 },
+        { "4k3/8/8/8/2p5/8/3N4/4K3 w - - 0 1", "d2b3", -450 },
+        { "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 100 },
+        { "4k3/2p5/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", 0 },
+        { "4k3/1P6/8/8/8/8/8/4K3 w - - 0 1", "b7b8q", 1200 },
+        { "2r1k3/1P6/8/8/8/8/8/4K3 w - - 0 1", "b7b8q", -100 },
+        { "1rk5/P7/8/8/8/8/8/4K3 w - - 0 1", "a7b8q", 575 },
+        { "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", "e1g1", 0 },
+    };
+
+    Board pos = {0};
+    int move, failures = 0, count = sizeof(Tests) / sizeof(Tests[0]);
+
+    for (int i = 0; i < count; i++) {
+
+        ParseFen(Tests[i].fen, &pos);
+        move = ParseMove(Tests[i].move, &pos);
+
+        if (   move == NONE_MOVE
+            || !see(&pos, move, Tests[i].value)
+            ||  see(&pos, move, Tests[i].value + 1)) {
+            printf("SEETest() [# %2d] %s %s expected %d\n",
+                i + 1, Tests[i].fen, Tests[i].move, Tests[i].value);
+            failures++;
+        }
+    }
+
+    printf("SEETest() finished %d tests with %s!\n", count, failures ? "failure" : "success");
+}
+
+static uint64_t fuzzRandom(uint64_t *seed) {
+
+    // SplitMix64, enough to wander through random games
+    uint64_t z = (*seed += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int fuzzMoveIsBroken(Board *pos, MoveList *list, int move, int *legal, int *pseudo) {
+
+    // moveIsLegal() must agree with the generator, and moveIsPseudoLegal()
+    // may only add moves which leave our King in check, or castle through
+    // an attack, so that a hash collision can never play an illegal move
+
+    int expected = MoveExists(list, move);
+    int isLegal  = moveIsLegal(pos, move);
+    int isPseudo = moveIsPseudoLegal(pos, move);
+    int inCheck  = 0;
+
+    *legal  += isLegal;
+    *pseudo += isPseudo;
+
+    // MakeMove() only accepts legal moves, so play the move on the
+    // occupancy instead, and look for attackers left on our King
+    if (isPseudo && !expected && !(move & MFLAGCA)) {
+
+        int from = SQ64(FROMSQ(move)), to = SQ64(TOSQ(move));
+        int ksq = PieceKing[pos->pieces[FROMSQ(move)]] ? to : SQ64(pos->KingSq[pos->side]);
+
+        uint64_t captured = move & MFLAGEP ? 1ull << (to + (pos->side == WHITE ? -8 : 8)) : 1ull << to;
+        uint64_t occupied = (pos->colourBB[COLOUR_NB] & ~(1ull << from) & ~captured) | (1ull << to);
+
+        inCheck = !!(attackersToSquare(pos, ksq, occupied) & pos->colourBB[!pos->side] & ~captured);
+    }
+
+    return isLegal != expected
+        || (expected && !isPseudo)
+        || (isPseudo && !expected && !(move & MFLAGCA) && !inCheck);
+}
+
+void MoveFuzzTest(int positions) {
+
+    // Play random games from positions rich in castling, en passant and
+    // promotions. At every position, check random encodings, generated
+    // moves with one bit flipped, the moves of earlier positions, which
+    // is what stale killers and hash collisions produce, and every move
+    // of the generator itself
+
+    static char *Roots[] = {
+        StartPosition,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+
+    static Undo history[MAXGAMEMOVES];
+    Board pos = { .history = history };
+    MoveList list = {0};
+    int pool[4096] = {0}, poolSize = 0, failures = 0;
+    int move, tested = 0, legal = 0, pseudo = 0, gamePly = 0;
+    uint64_t seed = 0x1F0A57ull;
+    double start = getTimeMs();
+
+    positions = positions > 0 ? positions : 100000;
+    ParseFen(Roots[0], &pos);
+
+    for (int i = 0; i < positions; i++) {
+
+        list.count = 0;
+        GenerateAllMoves(&pos, &list);
+
+        for (int j = 0; j < 48; j++, tested++) {
+
+            move = j % 3 == 0 ? (int)(fuzzRandom(&seed) & 0x1FFFFFF)
+                 : j % 3 == 1 && list.count ? list.moves[fuzzRandom(&seed) % list.count].move
+                                            ^ (1 << (fuzzRandom(&seed) % 25))
+                 : pool[fuzzRandom(&seed) % 4096];
+
+            if (fuzzMoveIsBroken(&pos, &list, move, &legal, &pseudo) && failures++ < 8)
+                printf("MoveFuzzTest() move %x %s\n", move, PrMove(move));
+        }
+
+        for (int j = 0; j < list.count; j++, tested++) {
+
+            move = pool[poolSize++ % 4096] = list.moves[j].move;
+
+            if (fuzzMoveIsBroken(&pos, &list, move, &legal, &pseudo) && failures++ < 8)
+                printf("MoveFuzzTest() move %x %s\n", move, PrMove(move));
+        }
+
+        // Start over once the game is over, or has gone on for long
+        if (!list.count || pos.fiftyMove >= 100 || ++gamePly >= MAX_PLY - 1) {
+            ParseFen(Roots[fuzzRandom(&seed) % 5], &pos);
+            gamePly = 0;
+        }
+
+        else MakeMove(&pos, list.moves[fuzzRandom(&seed) % list.count].move);
+    }
+
+    printf("MoveFuzzTest() positions %d moves %d legal %d pseudo %d failures %d time %dms\n",
+        positions, tested, legal, pseudo, failures, (int)(getTimeMs() - start));
+    printf("MoveFuzzTest() finished with %s!\n", failures ? "failure" : "success");
+}
@@ -18,7 +18,10 @@
 
 #pragma once
 
-void MirrorEvalTest(Board *pos);
+void MirrorEvalTest(Board *pos, Thread *thread);
+void TTStressTest(int nthreads);
+void SEETest();
+void MoveFuzzTest(int positions);
 
 #if defined(DEBUG)
 
@@ -30,7 +33,5 @@ int SideValid(const int side);
 int FileRankValid(const int fr);
 int PieceValidEmpty(const int pce);
 int PieceValid(const int pce);
-void Perft(int depth, Board *pos);
-void PerftTest(int depth, Board *pos);
 
 #endif
\ No newline at end of file